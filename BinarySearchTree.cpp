@@ -7,10 +7,25 @@
 // Description : Hello World in C++, Ansi-style
 //============================================================================
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <thread>
 #include <time.h>
+#include <vector>
 
-#include "CSVparser.hpp"
+#include "MappedCsv.hpp"
 
 using namespace std;
 
@@ -18,9 +33,14 @@ using namespace std;
 // Global definitions visible to all methods and classes
 //============================================================================
 
-// forward declarations
-double strToDouble(string str, char ch);
+//Number of keys SearchMany walks down the tree side by side.
+const unsigned int SEARCH_BATCH = 16;
 
+//Number of nodes a NodeArena allocates at a time.
+const size_t NODE_CHUNK_SIZE = 256;
+
+//Number of readers that can be taking a PersistentBidTree snapshot at the same instant. Any more retry for a free slot.
+const size_t SNAPSHOT_HAZARD_SLOTS = 64;
 
 // define a structure to hold bid information
 struct Bid {
@@ -34,7 +54,9 @@ struct Bid {
 };
 
 
-void displayBid(Bid bid);
+void displayBid(const Bid& bid);
+
+class FrozenBidIndex;
 
 
 
@@ -42,15 +64,6 @@ void displayBid(Bid bid);
 struct Node {
 public:
 
-	//Destructor for the node, checks for and deletes any child nodes, which do the same to their children.
-	~Node() {
-		if (left_child_node)
-			delete left_child_node;
-		if (right_child_node)
-			delete right_child_node;
-	}
-
-
 	//Data held in this node. This can be anything, from a simple int or char, to complicated classes. Whatever is meant to be held in the binary search tree as far as data.
 	Bid bid_data;
 
@@ -58,8 +71,285 @@ public:
 	Node* left_child_node;
 	Node* right_child_node;
 
+	//Height of the sub-tree rooted at this node, a leaf has a height of 1. Used by the self-balancing mode to decide when to rotate.
+	int height;
+
+	//Number of bids, and total of their amounts, in the sub-tree rooted at this node. Used to answer rank and range queries without visiting every node.
+	size_t subtree_size;
+	double subtree_sum;
+
+};
+
+//============================================================================
+// Node Arena class definition
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement a pool allocator owning every node of one tree.
+ *
+ * Nodes are handed out from contiguous chunks, so neighbouring
+ * inserts tend to share cache lines and pages, and there is no
+ * call into the heap per node. Freed nodes go on a free list
+ * (threaded through left_child_node) and are reused first.
+ * Releasing the arena frees the whole tree a chunk at a time,
+ * without walking it.
+ */
+class NodeArena {
+
+private:
+
+	//Every chunk of nodes allocated, the last one being the one currently handed out from.
+	vector< unique_ptr< Node[] > > chunks;
+
+	//How many nodes of the last chunk have been handed out, and how many it holds.
+	size_t chunk_used;
+	size_t chunk_capacity;
+
+	//Nodes given back by Free, waiting to be reused.
+	Node* free_list;
+
+public:
+	NodeArena();
+	Node* Allocate();								//A node with empty children.
+	Node* AllocateBlock(size_t count);				//count nodes, contiguous, in their own chunk.
+	void Free(Node* node);							//Give a node back for reuse.
+	void Release();									//Free every node at once.
+};
+
+/**
+ * Default constructor, an empty arena
+ */
+NodeArena::NodeArena() {
+	chunk_used = 0;
+	chunk_capacity = 0;
+	free_list = NULL;
+}
+
+/**
+ * A node with empty children, from the free list if there is one,
+ * otherwise the next unused node of the current chunk
+ */
+Node* NodeArena::Allocate() {
+	Node* node;
+	if (free_list != NULL) {
+		node = free_list;
+		free_list = node->left_child_node;
+	}
+	else {
+		if (chunk_used == chunk_capacity) {
+			chunks.emplace_back(new Node[NODE_CHUNK_SIZE]);
+			chunk_used = 0;
+			chunk_capacity = NODE_CHUNK_SIZE;
+		}
+		node = &chunks.back()[chunk_used++];
+	}
+	node->left_child_node = NULL;
+	node->right_child_node = NULL;
+	return node;
+}
+
+/**
+ * A run of contiguous nodes, in a chunk of their own. The chunk is
+ * full from the start, so the next Allocate starts a new chunk.
+ *
+ * @param count Number of nodes
+ * @return The first node of the run
+ */
+Node* NodeArena::AllocateBlock(size_t count) {
+	chunks.emplace_back(new Node[count]);
+	chunk_used = count;
+	chunk_capacity = count;
+	return chunks.back().get();
+}
+
+/**
+ * Give a node back. Its bid is cleared now so the strings are not
+ * held on to until the node is reused.
+ */
+void NodeArena::Free(Node* node) {
+	node->bid_data = Bid();
+	node->left_child_node = free_list;
+	free_list = node;
+}
+
+/**
+ * Free every node. This is one delete[] per chunk rather than a
+ * walk of the tree. Each chunk still runs its nodes' destructors
+ * to release the bid strings, but that is a straight sweep through
+ * contiguous memory.
+ */
+void NodeArena::Release() {
+	chunks.clear();
+	chunk_used = 0;
+	chunk_capacity = 0;
+	free_list = NULL;
+}
+
+//============================================================================
+// Bid Range class definition
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement a lazy, in-order view of the bids in a key range.
+ *
+ * Iterating yields a const reference to each bid where it sits in
+ * the tree, so nothing is copied or printed, and it works as a
+ * C++20 view (for example range | views::transform(&Bid::amount)).
+ * The iterator walks down to the first key in range once, then
+ * steps with an explicit stack of the ancestors still to visit, so
+ * each step is amortized O(1). Inserting or removing bids while a
+ * range is being iterated invalidates it.
+ */
+class BidRange : public std::ranges::view_interface< BidRange > {
+
+private:
+
+	Node* root;
+
+	//Lowest and highest bid id in range, inclusive. With unbounded set, there is no highest.
+	string lo;
+	string hi;
+	bool unbounded;
+
+public:
+
+	class iterator {
+
+	private:
+
+		//The current node on top, with the ancestors still to be visited beneath it. Empty at the end.
+		vector< const Node* > stack;
+
+		//The range the iterator belongs to, for its upper bound.
+		const BidRange* range;
+
+		void pushLeftSpine(const Node* node);
+		void checkUpperBound();
+
+		friend class BidRange;
+
+	public:
+		typedef std::forward_iterator_tag iterator_concept;
+		typedef std::forward_iterator_tag iterator_category;
+		typedef Bid value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const Bid& reference;
+		typedef const Bid* pointer;
+
+		iterator();
+		const Bid& operator*() const;
+		const Bid* operator->() const;
+		iterator& operator++();
+		iterator operator++(int);
+		bool operator==(const iterator& other) const;
+		bool operator==(std::default_sentinel_t) const;
+	};
+
+	BidRange(Node* root, string lo, string hi, bool unbounded);
+	iterator begin() const;
+	std::default_sentinel_t end() const;
 };
 
+/**
+ * The bids of a tree with an id from lo to hi inclusive, or from lo on if unbounded
+ */
+BidRange::BidRange(Node* root, string lo, string hi, bool unbounded) : root(root), lo(std::move(lo)), hi(std::move(hi)), unbounded(unbounded) {
+}
+
+/**
+ * Iterator at the first bid in range. Walking down, every node at
+ * or above lo is pushed before going left, so the stack ends up
+ * holding exactly the in-range ancestors still to be visited.
+ */
+BidRange::iterator BidRange::begin() const {
+	iterator it;
+	it.range = this;
+	const Node* node = root;
+	while (node != NULL) {
+		if (node->bid_data.bidId < lo)
+			node = node->right_child_node;
+		else {
+			it.stack.push_back(node);
+			node = node->left_child_node;
+		}
+	}
+	it.checkUpperBound();
+	return it;
+}
+
+/**
+ * The end of the range. An iterator compares equal to it once it has run out of bids.
+ */
+std::default_sentinel_t BidRange::end() const {
+	return std::default_sentinel;
+}
+
+/**
+ * An iterator at the end of an empty range
+ */
+BidRange::iterator::iterator() : range(nullptr) {
+}
+
+/**
+ * Push a node and every left child below it
+ */
+void BidRange::iterator::pushLeftSpine(const Node* node) {
+	while (node != NULL) {
+		stack.push_back(node);
+		node = node->left_child_node;
+	}
+}
+
+/**
+ * Move to the end once the next bid is past the highest id in range
+ */
+void BidRange::iterator::checkUpperBound() {
+	if (!stack.empty() && !range->unbounded && range->hi < stack.back()->bid_data.bidId)
+		stack.clear();
+}
+
+const Bid& BidRange::iterator::operator*() const {
+	return stack.back()->bid_data;
+}
+
+const Bid* BidRange::iterator::operator->() const {
+	return &stack.back()->bid_data;
+}
+
+/**
+ * Step to the next bid in key order: the lowest bid in the current
+ * node's right sub-tree if it has one, otherwise the nearest
+ * ancestor still waiting on the stack
+ */
+BidRange::iterator& BidRange::iterator::operator++() {
+	const Node* node = stack.back();
+	stack.pop_back();
+	pushLeftSpine(node->right_child_node);
+	checkUpperBound();
+	return *this;
+}
+
+BidRange::iterator BidRange::iterator::operator++(int) {
+	iterator previous = *this;
+	++*this;
+	return previous;
+}
+
+/**
+ * Two iterators over the same range are equal when they are at the same node, or both at the end
+ */
+bool BidRange::iterator::operator==(const iterator& other) const {
+	if (stack.empty() || other.stack.empty())
+		return stack.empty() && other.stack.empty();
+	return stack.back() == other.stack.back();
+}
+
+bool BidRange::iterator::operator==(std::default_sentinel_t) const {
+	return stack.empty();
+}
+
 //============================================================================
 // Binary Search Tree class definition
 //============================================================================
@@ -72,322 +362,2245 @@ class BinarySearchTree {
 
 private:
 
-	//The root node, which is the beginning of the binary search tree. The first entry.
+	//The root node, which is the beginning of the binary search tree. The first entry. NULL while the tree is empty.
     Node* root;
 
-	//Private helper functions used when calling the public functions, and using recursion.
-    void addNode(Node* node, Bid bid);
-    void inOrder(Node* node);
-    Node* removeNode(Node* node, string bidId);
+	//Whether inserts and removes rebalance the tree (AVL), keeping its height O(log n) whatever order the bids arrive in.
+	bool balanced;
+
+	//Owns every node in the tree.
+	NodeArena arena;
+
+	//Links (the root pointer, or a child pointer) from the root down to where an insert or remove happened, reused between calls.
+	vector< Node** > path;
+
+	//Private helper functions used when calling the public functions. All of them loop rather than recurse, so deep trees cannot overflow the stack.
+    void addNode(Bid bid);
+    void removeNode(string bidId);
+	void rebalancePath();
+	Node* buildBalanced(Node* block, vector<Bid>& bids, size_t begin, size_t end);
+
+	//Private helper functions used to keep the tree balanced.
+	static int nodeHeight(Node* node);
+	static size_t nodeSize(Node* node);
+	static double nodeSum(Node* node);
+	static void updateNode(Node* node);
+	static Node* rotateLeft(Node* node);
+	static Node* rotateRight(Node* node);
+	Node* rebalance(Node* node);
+
+	//Private helper functions used for the order statistic queries.
+	size_t countBelow(std::string_view bidId, bool inclusive);
+	double sumBelow(std::string_view bidId, bool inclusive);
 
 public:
 
 	//Outward, public facing functions used to perform operations on the binary search tree.
-    BinarySearchTree();
+    explicit BinarySearchTree(bool selfBalancing = false);
     virtual ~BinarySearchTree();
+    int Height();									//Height of the tree, 0 when empty.
     void InOrder();									//Display the values of the binary tree in order from least to greatest.
     void Insert(Bid bid);							//Insert a value into the tree.
+    void BulkLoad(vector<Bid>&& bids);				//Replace the contents of the tree with a perfectly balanced tree of the given bids.
     void Remove(string bidId);						//Remove and delete a node from the tree.
     Bid Search(string bidId);						//Search for a node in the tree provided an identifier.
-	Bid Search(Node* node, string bidId);			//Recursive function used to search down the tree.
+	Bid Search(Node* node, string bidId);			//Search down the tree from a given node.
+	void SearchMany(std::span<const std::string_view> bidIds, std::span<const Bid*> results);	//Search for many nodes at once, interleaving the walks.
+	size_t Size();									//Number of bids in the tree.
+	FrozenBidIndex Freeze();						//Read-only snapshot of the bids, laid out for fast searching.
+	size_t Rank(string bidId);						//Number of bids with an id less than the given one.
+	Bid Select(size_t k);							//The bid at position k (from 0) in id order.
+	size_t CountRange(string lo, string hi);		//Number of bids with an id from lo to hi inclusive.
+	double SumRange(string lo, string hi);			//Total amount of the bids with an id from lo to hi inclusive.
+	BidRange Range(string lo, string hi);			//Lazy view of the bids with an id from lo to hi inclusive, in order.
+	BidRange Range();								//Lazy view of every bid, in order.
 };
 
 /**
- * Default constructor
+ * Ask the CPU to start loading a cache line that will be read soon
+ *
+ * @param address Any address in the line
+ */
+static inline void prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_prefetch(address);
+#endif
+}
+
+/**
+ * Default constructor
+ *
+ * @param selfBalancing Keep the tree balanced as an AVL tree
+ */
+BinarySearchTree::BinarySearchTree(bool selfBalancing) {
+	root = NULL;
+	balanced = selfBalancing;
+}
+
+/**
+ * Destructor
+ */
+BinarySearchTree::~BinarySearchTree() {
+	//The arena owns every node, so releasing it frees the whole tree without walking it.
+	arena.Release();
+}
+
+
+
+
+/**
+ * Height of a sub-tree, treating a missing child as height 0
+ */
+int BinarySearchTree::nodeHeight(Node* node) {
+	return node ? node->height : 0;
+}
+
+/**
+ * Number of bids, and total amount, in a sub-tree that may be missing
+ */
+size_t BinarySearchTree::nodeSize(Node* node) {
+	return node ? node->subtree_size : 0;
+}
+
+double BinarySearchTree::nodeSum(Node* node) {
+	return node ? node->subtree_sum : 0.0;
+}
+
+/**
+ * Recompute a node's height, size and sum from its children
+ */
+void BinarySearchTree::updateNode(Node* node) {
+	node->height = 1 + max(nodeHeight(node->left_child_node), nodeHeight(node->right_child_node));
+	node->subtree_size = 1 + nodeSize(node->left_child_node) + nodeSize(node->right_child_node);
+	node->subtree_sum = node->bid_data.amount + nodeSum(node->left_child_node) + nodeSum(node->right_child_node);
+}
+
+/**
+ * Rotate a sub-tree to the left, lifting the right child into the node's place
+ *
+ * @param node Root of the sub-tree
+ * @return The new root of the sub-tree
+ */
+Node* BinarySearchTree::rotateLeft(Node* node) {
+	Node* pivot = node->right_child_node;
+	node->right_child_node = pivot->left_child_node;
+	pivot->left_child_node = node;
+	updateNode(node);
+	updateNode(pivot);
+	return pivot;
+}
+
+/**
+ * Rotate a sub-tree to the right, lifting the left child into the node's place
+ *
+ * @param node Root of the sub-tree
+ * @return The new root of the sub-tree
+ */
+Node* BinarySearchTree::rotateRight(Node* node) {
+	Node* pivot = node->left_child_node;
+	node->left_child_node = pivot->right_child_node;
+	pivot->right_child_node = node;
+	updateNode(node);
+	updateNode(pivot);
+	return pivot;
+}
+
+/**
+ * Update a node's height, size and sum after one of its sub-trees changed and,
+ * in self-balancing mode, rotate it back into AVL balance
+ *
+ * @param node Root of the sub-tree that changed
+ * @return The new root of the sub-tree
+ */
+Node* BinarySearchTree::rebalance(Node* node) {
+	updateNode(node);
+	if (!balanced)
+		return node;
+
+	int balance = nodeHeight(node->left_child_node) - nodeHeight(node->right_child_node);
+
+	//Left side too tall. A right-heavy left child needs its own rotation first (left-right case).
+	if (balance > 1) {
+		Node* left = node->left_child_node;
+		if (nodeHeight(left->left_child_node) < nodeHeight(left->right_child_node))
+			node->left_child_node = rotateLeft(left);
+		return rotateRight(node);
+	}
+
+	//Right side too tall, the mirror image of the above.
+	if (balance < -1) {
+		Node* right = node->right_child_node;
+		if (nodeHeight(right->right_child_node) < nodeHeight(right->left_child_node))
+			node->right_child_node = rotateRight(right);
+		return rotateLeft(node);
+	}
+
+	return node;
+}
+
+/**
+ * Height of the tree
+ */
+int BinarySearchTree::Height() {
+	return nodeHeight(root);
+}
+
+
+
+
+/**
+ * Number of bids in the tree
+ */
+size_t BinarySearchTree::Size() {
+	return nodeSize(root);
+}
+
+/**
+ * Number of bids with an id below (or, if inclusive, up to) a key.
+ * Walks a single path down the tree, adding up the sizes of the
+ * left sub-trees it passes on the way.
+ */
+size_t BinarySearchTree::countBelow(std::string_view bidId, bool inclusive) {
+	size_t count = 0;
+	Node* node = root;
+	while (node != NULL) {
+		if (node->bid_data.bidId < bidId || (inclusive && node->bid_data.bidId == bidId)) {
+			count += nodeSize(node->left_child_node) + 1;
+			node = node->right_child_node;
+		}
+		else
+			node = node->left_child_node;
+	}
+	return count;
+}
+
+/**
+ * Total amount of the bids with an id below (or, if inclusive, up to) a key, the same way as countBelow
+ */
+double BinarySearchTree::sumBelow(std::string_view bidId, bool inclusive) {
+	double sum = 0.0;
+	Node* node = root;
+	while (node != NULL) {
+		if (node->bid_data.bidId < bidId || (inclusive && node->bid_data.bidId == bidId)) {
+			sum += nodeSum(node->left_child_node) + node->bid_data.amount;
+			node = node->right_child_node;
+		}
+		else
+			node = node->left_child_node;
+	}
+	return sum;
+}
+
+/**
+ * Number of bids with an id less than the given one, which is the
+ * position the bid holds (or would hold) in id order
+ */
+size_t BinarySearchTree::Rank(string bidId) {
+	return countBelow(bidId, false);
+}
+
+/**
+ * The bid at position k in id order, counting from 0
+ *
+ * @return The bid, or an empty bid if k is past the end
+ */
+Bid BinarySearchTree::Select(size_t k) {
+	Node* node = root;
+	while (node != NULL) {
+		size_t leftSize = nodeSize(node->left_child_node);
+		if (k < leftSize)
+			node = node->left_child_node;
+		else if (k == leftSize)
+			return node->bid_data;
+		else {
+			k -= leftSize + 1;
+			node = node->right_child_node;
+		}
+	}
+	return Bid();
+}
+
+/**
+ * Number of bids with an id from lo to hi inclusive
+ */
+size_t BinarySearchTree::CountRange(string lo, string hi) {
+	if (hi < lo)
+		return 0;
+	return countBelow(hi, true) - countBelow(lo, false);
+}
+
+/**
+ * Total amount of the bids with an id from lo to hi inclusive
+ */
+double BinarySearchTree::SumRange(string lo, string hi) {
+	if (hi < lo)
+		return 0.0;
+	return sumBelow(hi, true) - sumBelow(lo, false);
+}
+
+
+
+
+/**
+ * Insert a bid into a node, and add it to the binary search tree.
+ */
+void BinarySearchTree::Insert(Bid bid) {
+    // Implement inserting a bid into the tree
+
+	//Call addNode to add it to a leaf and rebalance the path back up to the root.
+	addNode(bid);
+}
+
+
+
+
+/**
+ * Replace the contents of the tree with the given bids.
+ * Instead of inserting one at a time, the bids are sorted once
+ * (or just checked, when already in order, as the CSV usually is)
+ * and the tree is built directly: the middle bid becomes the root
+ * and each half becomes a sub-tree the same way. That is O(n)
+ * after the sort, the result is perfectly balanced, and every
+ * node comes from one contiguous block, laid out in key order.
+ *
+ * @param bids The bids to load. Their strings are moved into the tree.
+ */
+void BinarySearchTree::BulkLoad(vector<Bid>&& bids) {
+	arena.Release();
+	root = NULL;
+
+	auto byId = [](const Bid& a, const Bid& b) { return a.bidId < b.bidId; };
+	if (!is_sorted(bids.begin(), bids.end(), byId))
+		sort(bids.begin(), bids.end(), byId);
+
+	if (!bids.empty())
+		root = buildBalanced(arena.AllocateBlock(bids.size()), bids, 0, bids.size());
+	bids.clear();
+}
+
+/**
+ * Build a balanced sub-tree from a sorted range of bids (recursive,
+ * the depth is only log n). Node i of the block holds bid i.
+ *
+ * @param block The block of nodes, one per bid
+ * @param bids The sorted bids
+ * @param begin First bid of the range
+ * @param end One past the last bid of the range
+ * @return Root of the sub-tree, NULL for an empty range
+ */
+Node* BinarySearchTree::buildBalanced(Node* block, vector<Bid>& bids, size_t begin, size_t end) {
+	if (begin == end)
+		return NULL;
+
+	size_t middle = begin + (end - begin) / 2;
+	Node* node = &block[middle];
+	node->bid_data = std::move(bids[middle]);
+	node->left_child_node = buildBalanced(block, bids, begin, middle);
+	node->right_child_node = buildBalanced(block, bids, middle + 1, end);
+	updateNode(node);
+	return node;
+}
+
+
+
+
+/**
+ * Rebalance every link recorded in path, deepest first. Each link
+ * is the pointer to a sub-tree, so a rotation just writes the new
+ * sub-tree root through it. The links live in parent nodes, which
+ * do not move, so the ones higher up stay valid.
+ */
+void BinarySearchTree::rebalancePath() {
+	while (!path.empty()) {
+		Node** link = path.back();
+		path.pop_back();
+		*link = rebalance(*link);
+	}
+}
+
+
+
+
+/**
+ * Add a bid to the tree (iterative)
+ *
+ * @param bid Bid to be added
+ */
+void BinarySearchTree::addNode(Bid bid) {
+
+	//Walk down to the empty link the new leaf belongs at, remembering the way. It goes on the right if it's equal or greater.
+	Node** link = &root;
+	while (*link != NULL) {
+		path.push_back(link);
+		Node* node = *link;
+		link = node->bid_data.bidId > bid.bidId ? &node->left_child_node : &node->right_child_node;
+	}
+
+	Node* leaf = arena.Allocate();
+	leaf->bid_data = std::move(bid);
+	updateNode(leaf);
+	*link = leaf;
+
+	//On the way back up, fix the heights and rotate wherever the new leaf tipped the balance.
+	rebalancePath();
+}
+
+
+
+
+/**
+ * Remove a bid
+ */
+void BinarySearchTree::Remove(string bidId) {
+
+	//Call removeNode and it will handle finding and removing the proper node.
+	removeNode(bidId);
+
+}
+
+
+
+
+
+/**
+ * Find and remove a bid (iterative)
+ *
+ * @param bidId The bid id to remove
+ */
+void BinarySearchTree::removeNode(string bidId) {
+
+	//First, walk down to the link holding the bid, remembering the way.
+	Node** link = &root;
+	while (*link != NULL && (*link)->bid_data.bidId != bidId) {
+		path.push_back(link);
+		Node* node = *link;
+		link = node->bid_data.bidId > bidId ? &node->left_child_node : &node->right_child_node;
+	}
+
+	//Not in the tree.
+	if (*link == NULL) {
+		path.clear();
+		return;
+	}
+
+	Node* target = *link;
+
+	//With two children, find the lowest value in the right sub-tree, move its bid up into this node and unlink that node instead.
+	if (target->left_child_node && target->right_child_node) {
+		path.push_back(link);
+		Node** successorLink = &target->right_child_node;
+		while ((*successorLink)->left_child_node != NULL) {
+			path.push_back(successorLink);
+			successorLink = &(*successorLink)->left_child_node;
+		}
+
+		Node* successor = *successorLink;
+		target->bid_data = std::move(successor->bid_data);
+		*successorLink = successor->right_child_node;
+		arena.Free(successor);
+	}
+
+	//Otherwise, there is at most one child, which takes this node's place.
+	else {
+		*link = target->left_child_node ? target->left_child_node : target->right_child_node;
+		arena.Free(target);
+	}
+
+	//Fix the heights and balance on the way back up.
+	rebalancePath();
+}
+
+
+
+/**
+ * Search for a bid
+ */
+Bid BinarySearchTree::Search(string bidId) {
+
+	//Call the search function, using the root node as a starting point.
+	return Search(root, bidId);
+}
+
+
+
+
+//Overloaded search function that can start from any node in the tree.
+Bid BinarySearchTree::Search(Node* node, string bidId) {
+
+	//Walk down, going left when the bidId is less than the node's value and right when greater, until the matching node turns up or the walk runs off the tree.
+	while (node != NULL) {
+		if (node->bid_data.bidId == bidId)
+			return node->bid_data;
+		node = bidId < node->bid_data.bidId ? node->left_child_node : node->right_child_node;
+	}
+
+	//The empty bid structure to return when not found.
+	return Bid();
+}
+
+
+
+
+/**
+ * Search for many bids at once.
+ * Walking down a tree is one cache miss per level, and a single
+ * search cannot start the next miss until the last one resolves.
+ * Here up to SEARCH_BATCH searches walk down together, one level
+ * each per pass, and every walk prefetches its next node before
+ * the pass moves on to the others. By the time a walk comes back
+ * around its node has usually arrived.
+ *
+ * @param bidIds The bid ids to search for
+ * @param results Receives a pointer to each bid in the tree, or nullptr if not found. Must be as long as bidIds. The pointers are valid until the tree is next changed.
+ */
+void BinarySearchTree::SearchMany(std::span<const std::string_view> bidIds, std::span<const Bid*> results) {
+	Node* cursors[SEARCH_BATCH];
+
+	for (size_t begin = 0; begin < bidIds.size(); begin += SEARCH_BATCH) {
+		size_t count = std::min<size_t>(SEARCH_BATCH, bidIds.size() - begin);
+		for (size_t i = 0; i < count; i++) {
+			cursors[i] = root;
+			results[begin + i] = nullptr;
+		}
+
+		//Keep making passes over the batch until every walk has found its bid or fallen off the tree.
+		size_t active = count;
+		while (active > 0) {
+			active = 0;
+			for (size_t i = 0; i < count; i++) {
+				Node* node = cursors[i];
+				if (node == NULL)
+					continue;
+
+				std::string_view bidId = bidIds[begin + i];
+				if (bidId == node->bid_data.bidId) {
+					results[begin + i] = &node->bid_data;
+					cursors[i] = NULL;
+					continue;
+				}
+
+				//Step down one level and start loading the child, then go and work on the other walks.
+				node = bidId < node->bid_data.bidId ? node->left_child_node : node->right_child_node;
+				if (node != NULL) {
+					prefetch(node);
+					active++;
+				}
+				cursors[i] = node;
+			}
+		}
+	}
+}
+
+/**
+ * Traverse the tree in order
+ */
+void BinarySearchTree::InOrder() {
+
+	//Display every bid from least to greatest. The output is flushed once at the end rather than after every row.
+	for (const Bid& bid : Range()) {
+		displayBid(bid);
+	}
+	cout.flush();
+
+}
+
+
+
+
+/**
+ * Lazy view of the bids with an id from lo to hi inclusive, in id order
+ */
+BidRange BinarySearchTree::Range(string lo, string hi) {
+	return BidRange(root, std::move(lo), std::move(hi), false);
+}
+
+/**
+ * Lazy view of every bid, in id order
+ */
+BidRange BinarySearchTree::Range() {
+	return BidRange(root, "", "", true);
+}
+
+
+
+
+
+//============================================================================
+// Amount Index class definition
+//============================================================================
+
+//Internal structure for an amount index node. Holds just the key, not the whole bid.
+struct AmountNode {
+	double amount;
+	string bid_id;
+	AmountNode* left_child_node;
+	AmountNode* right_child_node;
+	int height;
+	size_t subtree_size;
+};
+
+/**
+ * Define a class containing data members and methods to
+ * implement a second index over the bids, ordered by amount.
+ *
+ * It is a self-balancing (AVL) tree keyed on amount, with bid id
+ * breaking ties so every bid has its own place, and augmented with
+ * sub-tree sizes so the k-th amount is found in O(log n). Median,
+ * percentiles and "k-th highest bid" come straight out of it,
+ * without a scan or a sort.
+ */
+class AmountIndex {
+
+private:
+
+	//The root node. NULL while the index is empty.
+	AmountNode* root;
+
+	//Private helper functions used when calling the public functions, and using recursion.
+	static bool lessThan(double amount, const string& bidId, AmountNode* node);
+	static int nodeHeight(AmountNode* node);
+	static size_t nodeSize(AmountNode* node);
+	static void updateNode(AmountNode* node);
+	static AmountNode* rotateLeft(AmountNode* node);
+	static AmountNode* rotateRight(AmountNode* node);
+	static AmountNode* rebalance(AmountNode* node);
+	static AmountNode* addNode(AmountNode* node, double amount, const string& bidId);
+	static AmountNode* removeNode(AmountNode* node, double amount, const string& bidId);
+	static void destroyTree(AmountNode* node);
+
+public:
+	AmountIndex();
+	virtual ~AmountIndex();
+	void Insert(const Bid& bid);					//Add a bid's amount to the index.
+	void Remove(const Bid& bid);					//Take a bid's amount out of the index. The bid must be as it was inserted.
+	size_t Size();									//Number of bids in the index.
+	double Select(size_t k);						//The k-th lowest amount, counting from 0.
+	double KthHighest(size_t k);					//The k-th highest amount, counting from 1.
+	double Percentile(double percent);				//The amount at a percentile (0 - 100), by the nearest rank method.
+};
+
+/**
+ * Default constructor
+ */
+AmountIndex::AmountIndex() {
+	root = NULL;
+}
+
+/**
+ * Destructor
+ */
+AmountIndex::~AmountIndex() {
+	destroyTree(root);
+}
+
+/**
+ * Release a node and all of its children (recursive, the depth is only log n)
+ */
+void AmountIndex::destroyTree(AmountNode* node) {
+	if (node == NULL)
+		return;
+	destroyTree(node->left_child_node);
+	destroyTree(node->right_child_node);
+	delete node;
+}
+
+/**
+ * Whether a key (amount, then bid id) comes before a node's key
+ */
+bool AmountIndex::lessThan(double amount, const string& bidId, AmountNode* node) {
+	if (amount != node->amount)
+		return amount < node->amount;
+	return bidId < node->bid_id;
+}
+
+int AmountIndex::nodeHeight(AmountNode* node) {
+	return node ? node->height : 0;
+}
+
+size_t AmountIndex::nodeSize(AmountNode* node) {
+	return node ? node->subtree_size : 0;
+}
+
+/**
+ * Recompute a node's height and size from its children
+ */
+void AmountIndex::updateNode(AmountNode* node) {
+	node->height = 1 + max(nodeHeight(node->left_child_node), nodeHeight(node->right_child_node));
+	node->subtree_size = 1 + nodeSize(node->left_child_node) + nodeSize(node->right_child_node);
+}
+
+AmountNode* AmountIndex::rotateLeft(AmountNode* node) {
+	AmountNode* pivot = node->right_child_node;
+	node->right_child_node = pivot->left_child_node;
+	pivot->left_child_node = node;
+	updateNode(node);
+	updateNode(pivot);
+	return pivot;
+}
+
+AmountNode* AmountIndex::rotateRight(AmountNode* node) {
+	AmountNode* pivot = node->left_child_node;
+	node->left_child_node = pivot->right_child_node;
+	pivot->right_child_node = node;
+	updateNode(node);
+	updateNode(pivot);
+	return pivot;
+}
+
+/**
+ * Update a node after one of its sub-trees changed, and rotate it back into AVL balance
+ *
+ * @return The new root of the sub-tree
+ */
+AmountNode* AmountIndex::rebalance(AmountNode* node) {
+	updateNode(node);
+	int balance = nodeHeight(node->left_child_node) - nodeHeight(node->right_child_node);
+
+	if (balance > 1) {
+		if (nodeHeight(node->left_child_node->left_child_node) < nodeHeight(node->left_child_node->right_child_node))
+			node->left_child_node = rotateLeft(node->left_child_node);
+		return rotateRight(node);
+	}
+	if (balance < -1) {
+		if (nodeHeight(node->right_child_node->right_child_node) < nodeHeight(node->right_child_node->left_child_node))
+			node->right_child_node = rotateRight(node->right_child_node);
+		return rotateLeft(node);
+	}
+	return node;
+}
+
+/**
+ * Add a key under a node (recursive)
+ *
+ * @return The new root of the sub-tree
+ */
+AmountNode* AmountIndex::addNode(AmountNode* node, double amount, const string& bidId) {
+	if (node == NULL) {
+		node = new AmountNode();
+		node->amount = amount;
+		node->bid_id = bidId;
+		updateNode(node);
+		return node;
+	}
+
+	if (lessThan(amount, bidId, node))
+		node->left_child_node = addNode(node->left_child_node, amount, bidId);
+	else
+		node->right_child_node = addNode(node->right_child_node, amount, bidId);
+	return rebalance(node);
+}
+
+/**
+ * Remove a key from under a node (recursive)
+ *
+ * @return The new root of the sub-tree
+ */
+AmountNode* AmountIndex::removeNode(AmountNode* node, double amount, const string& bidId) {
+	if (node == NULL)
+		return NULL;
+
+	if (lessThan(amount, bidId, node))
+		node->left_child_node = removeNode(node->left_child_node, amount, bidId);
+	else if (amount != node->amount || bidId != node->bid_id)
+		node->right_child_node = removeNode(node->right_child_node, amount, bidId);
+
+	//This is the node. With two children, take over the lowest key on the right and remove that instead.
+	else if (node->left_child_node && node->right_child_node) {
+		AmountNode* successor = node->right_child_node;
+		while (successor->left_child_node != NULL) {
+			successor = successor->left_child_node;
+		}
+		node->amount = successor->amount;
+		node->bid_id = successor->bid_id;
+		node->right_child_node = removeNode(node->right_child_node, successor->amount, successor->bid_id);
+	}
+	else {
+		AmountNode* child = node->left_child_node ? node->left_child_node : node->right_child_node;
+		delete node;
+		return child;
+	}
+	return rebalance(node);
+}
+
+void AmountIndex::Insert(const Bid& bid) {
+	root = addNode(root, bid.amount, bid.bidId);
+}
+
+void AmountIndex::Remove(const Bid& bid) {
+	root = removeNode(root, bid.amount, bid.bidId);
+}
+
+size_t AmountIndex::Size() {
+	return nodeSize(root);
+}
+
+/**
+ * The k-th lowest amount, counting from 0
+ *
+ * @return The amount, or -1 if k is past the end
+ */
+double AmountIndex::Select(size_t k) {
+	AmountNode* node = root;
+	while (node != NULL) {
+		size_t leftSize = nodeSize(node->left_child_node);
+		if (k < leftSize)
+			node = node->left_child_node;
+		else if (k == leftSize)
+			return node->amount;
+		else {
+			k -= leftSize + 1;
+			node = node->right_child_node;
+		}
+	}
+	return -1;
+}
+
+/**
+ * The k-th highest amount, so KthHighest(1) is the highest
+ *
+ * @return The amount, or -1 if there are fewer than k bids
+ */
+double AmountIndex::KthHighest(size_t k) {
+	if (k == 0 || k > Size())
+		return -1;
+	return Select(Size() - k);
+}
+
+/**
+ * The amount at a percentile, by the nearest rank method: the
+ * smallest amount that at least that percent of bids are at or below
+ *
+ * @param percent The percentile, from 0 to 100
+ * @return The amount, or -1 if the index is empty
+ */
+double AmountIndex::Percentile(double percent) {
+	size_t size = Size();
+	if (size == 0)
+		return -1;
+
+	size_t rank = (size_t)ceil(percent / 100.0 * size);
+	return Select(rank > 0 ? rank - 1 : 0);
+}
+
+
+
+
+
+//============================================================================
+// B+ Tree class definition
+//============================================================================
+
+/**
+ * Order preserving 8 byte prefix of a key. The first 8 bytes are
+ * packed big endian and zero padded, so comparing two prefixes
+ * as integers gives the same order as comparing the strings.
+ * Bid ids are short, so the prefix almost always settles the
+ * comparison without touching the string itself.
+ *
+ * @param key The key to pack
+ * @return The packed prefix
+ */
+static inline uint64_t keyPrefix(std::string_view key) {
+	uint64_t prefix = 0;
+	for (size_t i = 0; i < 8; i++) {
+		prefix = (prefix << 8) | (i < key.size() ? (uint8_t)key[i] : 0);
+	}
+	return prefix;
+}
+
+/**
+ * Compare a key against a stored key, prefix first
+ *
+ * @return Less than, equal to or greater than zero, as for strcmp
+ */
+static inline int compareKey(uint64_t prefix, std::string_view key, uint64_t storedPrefix, std::string_view storedKey) {
+	if (prefix != storedPrefix)
+		return prefix < storedPrefix ? -1 : 1;
+	return key.compare(storedKey);
+}
+
+//Keys in an inner node, and bids in a leaf. Sized so the parts of a node that searches read fit in a few cache lines.
+const int BPLUS_INNER_KEYS = 15;
+const int BPLUS_LEAF_KEYS = 16;
+
+//Fields shared by both kinds of node, used to tell them apart.
+struct BPlusNode {
+	bool is_leaf;
+	int key_count;
+};
+
+//Inner node. Holds only separator keys and child pointers. Child i holds the keys from separator i - 1 up to, but not including, separator i.
+struct alignas(64) BPlusInner : BPlusNode {
+
+	//Prefixes of the separators, all a search needs to read unless two prefixes tie.
+	uint64_t key_prefixes[BPLUS_INNER_KEYS];
+	BPlusNode* children[BPLUS_INNER_KEYS + 1];
+
+	//Whole separator keys, only read when prefixes tie. Kept after the hot fields so they stay out of the searched cache lines.
+	string keys[BPLUS_INNER_KEYS];
+};
+
+//Leaf node. Holds the bids themselves in key order, and links to the next leaf for ordered scans.
+struct alignas(64) BPlusLeaf : BPlusNode {
+	uint64_t key_prefixes[BPLUS_LEAF_KEYS];
+	BPlusLeaf* next_leaf;
+	Bid bids[BPLUS_LEAF_KEYS];
+};
+
+/**
+ * Define a class containing data members and methods to
+ * implement a B+ tree index of bids keyed on bid id.
+ *
+ * Unlike BinarySearchTree, every comparison on the way down is
+ * against a packed prefix in a wide inner node, so a lookup
+ * touches a handful of cache lines per level over very few
+ * levels. The bids live only in the leaves, and the leaves are
+ * linked together so ordered scans never go back up the tree.
+ */
+class BPlusTree {
+
+private:
+
+	//The root node, a leaf until the first split. NULL while the tree is empty.
+	BPlusNode* root;
+
+	//The first leaf in key order, where full scans start.
+	BPlusLeaf* first_leaf;
+
+	//Number of bids in the tree.
+	size_t bid_count;
+
+	//What a node hands back to its parent when it splits.
+	struct Split {
+		uint64_t key_prefix;
+		string key;
+		BPlusNode* right_node;
+	};
+
+	//Private helper functions used when calling the public functions.
+	bool insert(BPlusNode* node, Bid& bid, uint64_t prefix, Split& split);
+	BPlusLeaf* findLeaf(uint64_t prefix, std::string_view bidId);
+	static int childIndex(BPlusInner* inner, uint64_t prefix, std::string_view bidId);
+	static int leafIndex(BPlusLeaf* leaf, uint64_t prefix, std::string_view bidId);
+	static void destroy(BPlusNode* node);
+
+public:
+	BPlusTree();
+	virtual ~BPlusTree();
+	void Insert(Bid bid);								//Insert a bid, replacing one with the same id.
+	void Remove(string bidId);							//Remove a bid. Leaves are allowed to run empty rather than merging.
+	Bid Search(string bidId);							//Search for a bid provided an identifier.
+	void InOrder();										//Display every bid in key order.
+	size_t Size();										//Number of bids in the tree.
+
+	//Call visit on every bid with an id from lo to hi inclusive, in key order.
+	template <typename Visitor>
+	void Range(std::string_view lo, std::string_view hi, Visitor visit);
+};
+
+/**
+ * Default constructor
+ */
+BPlusTree::BPlusTree() {
+	root = NULL;
+	first_leaf = NULL;
+	bid_count = 0;
+}
+
+/**
+ * Destructor
+ */
+BPlusTree::~BPlusTree() {
+	destroy(root);
+}
+
+/**
+ * Delete a node and everything under it
+ */
+void BPlusTree::destroy(BPlusNode* node) {
+	if (node == NULL)
+		return;
+
+	if (node->is_leaf) {
+		delete static_cast<BPlusLeaf*>(node);
+		return;
+	}
+
+	BPlusInner* inner = static_cast<BPlusInner*>(node);
+	for (int i = 0; i <= inner->key_count; i++) {
+		destroy(inner->children[i]);
+	}
+	delete inner;
+}
+
+/**
+ * Which child of an inner node a key belongs under.
+ * This is the number of separators less than or equal to the key,
+ * found with a linear scan since the whole prefix array is a few
+ * cache lines.
+ */
+int BPlusTree::childIndex(BPlusInner* inner, uint64_t prefix, std::string_view bidId) {
+	int index = 0;
+	while (index < inner->key_count && compareKey(prefix, bidId, inner->key_prefixes[index], inner->keys[index]) >= 0) {
+		index++;
+	}
+	return index;
+}
+
+/**
+ * Position of the first bid in a leaf with an id not less than the key
+ */
+int BPlusTree::leafIndex(BPlusLeaf* leaf, uint64_t prefix, std::string_view bidId) {
+	int index = 0;
+	while (index < leaf->key_count && compareKey(prefix, bidId, leaf->key_prefixes[index], leaf->bids[index].bidId) > 0) {
+		index++;
+	}
+	return index;
+}
+
+/**
+ * Walk down from the root to the leaf a key belongs in
+ *
+ * @return The leaf, or NULL when the tree is empty
+ */
+BPlusLeaf* BPlusTree::findLeaf(uint64_t prefix, std::string_view bidId) {
+	BPlusNode* node = root;
+	while (node != NULL && !node->is_leaf) {
+		BPlusInner* inner = static_cast<BPlusInner*>(node);
+		node = inner->children[childIndex(inner, prefix, bidId)];
+	}
+	return static_cast<BPlusLeaf*>(node);
+}
+
+/**
+ * Insert a bid into a tree
+ */
+void BPlusTree::Insert(Bid bid) {
+	uint64_t prefix = keyPrefix(bid.bidId);
+
+	//First bid, the root starts out as a single leaf.
+	if (root == NULL) {
+		BPlusLeaf* leaf = new BPlusLeaf();
+		leaf->is_leaf = true;
+		leaf->key_count = 0;
+		leaf->next_leaf = NULL;
+		root = leaf;
+		first_leaf = leaf;
+	}
+
+	//If the root itself split, grow the tree by one level with a new root over the two halves.
+	Split split;
+	if (insert(root, bid, prefix, split)) {
+		BPlusInner* newRoot = new BPlusInner();
+		newRoot->is_leaf = false;
+		newRoot->key_count = 1;
+		newRoot->key_prefixes[0] = split.key_prefix;
+		newRoot->keys[0] = split.key;
+		newRoot->children[0] = root;
+		newRoot->children[1] = split.right_node;
+		root = newRoot;
+	}
+}
+
+/**
+ * Insert a bid under a node (recursive, the tree is only a few levels deep)
+ *
+ * @param node Current node in tree
+ * @param bid Bid to be added
+ * @param prefix Packed prefix of the bid id
+ * @param split Filled in if this node had to split
+ * @return True if this node split and the parent must add split.right_node
+ */
+bool BPlusTree::insert(BPlusNode* node, Bid& bid, uint64_t prefix, Split& split) {
+
+	if (node->is_leaf) {
+		BPlusLeaf* leaf = static_cast<BPlusLeaf*>(node);
+		int index = leafIndex(leaf, prefix, bid.bidId);
+
+		//Same id already in the tree, replace it.
+		if (index < leaf->key_count && leaf->bids[index].bidId == bid.bidId) {
+			leaf->bids[index] = std::move(bid);
+			return false;
+		}
+		bid_count++;
+
+		//Room in this leaf, shift the larger bids up one and drop the new bid in.
+		if (leaf->key_count < BPLUS_LEAF_KEYS) {
+			for (int i = leaf->key_count; i > index; i--) {
+				leaf->key_prefixes[i] = leaf->key_prefixes[i - 1];
+				leaf->bids[i] = std::move(leaf->bids[i - 1]);
+			}
+			leaf->key_prefixes[index] = prefix;
+			leaf->bids[index] = std::move(bid);
+			leaf->key_count++;
+			return false;
+		}
+
+		//Leaf is full. Move the upper half into a new leaf linked in after this one, then insert into whichever half the bid belongs in.
+		BPlusLeaf* right = new BPlusLeaf();
+		right->is_leaf = true;
+		int half = BPLUS_LEAF_KEYS / 2;
+		for (int i = half; i < BPLUS_LEAF_KEYS; i++) {
+			right->key_prefixes[i - half] = leaf->key_prefixes[i];
+			right->bids[i - half] = std::move(leaf->bids[i]);
+		}
+		right->key_count = BPLUS_LEAF_KEYS - half;
+		leaf->key_count = half;
+		right->next_leaf = leaf->next_leaf;
+		leaf->next_leaf = right;
+
+		BPlusLeaf* target = index <= half ? leaf : right;
+		if (target == right)
+			index -= half;
+		for (int i = target->key_count; i > index; i--) {
+			target->key_prefixes[i] = target->key_prefixes[i - 1];
+			target->bids[i] = std::move(target->bids[i - 1]);
+		}
+		target->key_prefixes[index] = prefix;
+		target->bids[index] = std::move(bid);
+		target->key_count++;
+
+		//The first key of the new leaf becomes the separator in the parent.
+		split.key_prefix = right->key_prefixes[0];
+		split.key = right->bids[0].bidId;
+		split.right_node = right;
+		return true;
+	}
+
+	BPlusInner* inner = static_cast<BPlusInner*>(node);
+	int index = childIndex(inner, prefix, bid.bidId);
+
+	Split childSplit;
+	if (!insert(inner->children[index], bid, prefix, childSplit))
+		return false;
+
+	//Child split, so its new right half goes in just after it. Room in this node, shift the larger separators up one.
+	if (inner->key_count < BPLUS_INNER_KEYS) {
+		for (int i = inner->key_count; i > index; i--) {
+			inner->key_prefixes[i] = inner->key_prefixes[i - 1];
+			inner->keys[i] = std::move(inner->keys[i - 1]);
+			inner->children[i + 1] = inner->children[i];
+		}
+		inner->key_prefixes[index] = childSplit.key_prefix;
+		inner->keys[index] = std::move(childSplit.key);
+		inner->children[index + 1] = childSplit.right_node;
+		inner->key_count++;
+		return false;
+	}
+
+	//This node is full too. Lay out all the separators and children with the new one in place, then split them around the middle separator, which moves up to the parent.
+	uint64_t prefixes[BPLUS_INNER_KEYS + 1];
+	string keys[BPLUS_INNER_KEYS + 1];
+	BPlusNode* children[BPLUS_INNER_KEYS + 2];
+	for (int i = 0, j = 0; i <= BPLUS_INNER_KEYS; i++) {
+		if (i == index) {
+			prefixes[i] = childSplit.key_prefix;
+			keys[i] = std::move(childSplit.key);
+		}
+		else {
+			prefixes[i] = inner->key_prefixes[j];
+			keys[i] = std::move(inner->keys[j]);
+			j++;
+		}
+	}
+	for (int i = 0, j = 0; i <= BPLUS_INNER_KEYS + 1; i++) {
+		if (i == index + 1)
+			children[i] = childSplit.right_node;
+		else
+			children[i] = inner->children[j++];
+	}
+
+	int middle = (BPLUS_INNER_KEYS + 1) / 2;
+	BPlusInner* right = new BPlusInner();
+	right->is_leaf = false;
+
+	inner->key_count = middle;
+	for (int i = 0; i < middle; i++) {
+		inner->key_prefixes[i] = prefixes[i];
+		inner->keys[i] = std::move(keys[i]);
+		inner->children[i] = children[i];
+	}
+	inner->children[middle] = children[middle];
+
+	right->key_count = BPLUS_INNER_KEYS - middle;
+	for (int i = middle + 1; i <= BPLUS_INNER_KEYS; i++) {
+		right->key_prefixes[i - middle - 1] = prefixes[i];
+		right->keys[i - middle - 1] = std::move(keys[i]);
+		right->children[i - middle - 1] = children[i];
+	}
+	right->children[right->key_count] = children[BPLUS_INNER_KEYS + 1];
+
+	split.key_prefix = prefixes[middle];
+	split.key = std::move(keys[middle]);
+	split.right_node = right;
+	return true;
+}
+
+/**
+ * Remove a bid. The bid is taken out of its leaf and nothing is
+ * merged, the separators above stay valid for the remaining keys.
+ */
+void BPlusTree::Remove(string bidId) {
+	uint64_t prefix = keyPrefix(bidId);
+	BPlusLeaf* leaf = findLeaf(prefix, bidId);
+	if (leaf == NULL)
+		return;
+
+	int index = leafIndex(leaf, prefix, bidId);
+	if (index == leaf->key_count || leaf->bids[index].bidId != bidId)
+		return;
+
+	for (int i = index; i < leaf->key_count - 1; i++) {
+		leaf->key_prefixes[i] = leaf->key_prefixes[i + 1];
+		leaf->bids[i] = std::move(leaf->bids[i + 1]);
+	}
+	leaf->key_count--;
+	leaf->bids[leaf->key_count] = Bid();
+	bid_count--;
+}
+
+/**
+ * Search for a bid
+ */
+Bid BPlusTree::Search(string bidId) {
+	uint64_t prefix = keyPrefix(bidId);
+	BPlusLeaf* leaf = findLeaf(prefix, bidId);
+	if (leaf == NULL)
+		return Bid();
+
+	int index = leafIndex(leaf, prefix, bidId);
+	if (index < leaf->key_count && leaf->bids[index].bidId == bidId)
+		return leaf->bids[index];
+	return Bid();
+}
+
+/**
+ * Call visit on every bid with an id from lo to hi inclusive, in
+ * key order. Only the first leaf is found through the tree, the
+ * rest of the scan follows the leaf links.
+ *
+ * @param lo The lowest bid id to visit
+ * @param hi The highest bid id to visit
+ * @param visit Called with a const Bid& for each bid in range
+ */
+template <typename Visitor>
+void BPlusTree::Range(std::string_view lo, std::string_view hi, Visitor visit) {
+	uint64_t loPrefix = keyPrefix(lo);
+	uint64_t hiPrefix = keyPrefix(hi);
+
+	BPlusLeaf* leaf = findLeaf(loPrefix, lo);
+	int index = leaf ? leafIndex(leaf, loPrefix, lo) : 0;
+	for (; leaf != NULL; leaf = leaf->next_leaf, index = 0) {
+		for (; index < leaf->key_count; index++) {
+			if (compareKey(hiPrefix, hi, leaf->key_prefixes[index], leaf->bids[index].bidId) < 0)
+				return;
+			visit(leaf->bids[index]);
+		}
+	}
+}
+
+/**
+ * Display every bid in key order by walking the leaf links
+ */
+void BPlusTree::InOrder() {
+	for (BPlusLeaf* leaf = first_leaf; leaf != NULL; leaf = leaf->next_leaf) {
+		for (int i = 0; i < leaf->key_count; i++) {
+			displayBid(leaf->bids[i]);
+		}
+	}
+}
+
+/**
+ * Number of bids in the tree
+ */
+size_t BPlusTree::Size() {
+	return bid_count;
+}
+
+
+
+
+
+//============================================================================
+// Frozen Bid Index class definition
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement a read-only snapshot of the bids for fast lookups.
+ *
+ * The keys are packed into 8 byte prefixes (see keyPrefix) and
+ * stored in Eytzinger (breadth first) order: the root at 1, the
+ * children of k at 2k and 2k + 1. A search is then a loop with no
+ * data dependent branches that walks down one contiguous array.
+ * The 16 descendants of k four levels down are adjacent, 128 bytes
+ * of prefixes, so the search prefetches them as two 64 byte cache
+ * lines while it works through the levels in between. The bids
+ * themselves are kept separately, in key order, and are only
+ * touched once the search has found its position.
+ */
+class FrozenBidIndex {
+
+private:
+
+	//Key prefixes in Eytzinger order, from index 1. Index 0 is unused.
+	vector< uint64_t > key_prefixes;
+
+	//For each Eytzinger position, where that key sits in the sorted bids.
+	vector< uint32_t > sorted_rank;
+
+	//The bids in key order.
+	vector< Bid > bids;
+
+	//Private helper function used to lay the keys out, recursing to the depth of the layout only.
+	void layout(size_t k, size_t& next);
+
+public:
+	FrozenBidIndex();
+	explicit FrozenBidIndex(vector<Bid>&& bids);		//Build from bids in any order.
+	const Bid* Find(std::string_view bidId) const;		//The stored bid, or nullptr if not found.
+	Bid Search(string bidId) const;					//A copy of the bid, or an empty bid if not found.
+	size_t Size() const;								//Number of bids in the index.
+};
+
+/**
+ * Default constructor, an empty index
+ */
+FrozenBidIndex::FrozenBidIndex() : key_prefixes(1, 0), sorted_rank(1, 0) {
+}
+
+/**
+ * Build the index from bids in any order, such as straight from loadBids
+ *
+ * @param unsortedBids The bids. Their strings are moved into the index.
+ */
+FrozenBidIndex::FrozenBidIndex(vector<Bid>&& unsortedBids) : bids(std::move(unsortedBids)) {
+	auto byId = [](const Bid& a, const Bid& b) { return a.bidId < b.bidId; };
+	if (!is_sorted(bids.begin(), bids.end(), byId))
+		sort(bids.begin(), bids.end(), byId);
+
+	key_prefixes.assign(bids.size() + 1, 0);
+	sorted_rank.assign(bids.size() + 1, 0);
+	size_t next = 0;
+	layout(1, next);
+}
+
+/**
+ * Fill the Eytzinger arrays with an in-order walk of the implicit
+ * tree, so the k-th position visited gets the k-th smallest key
+ *
+ * @param k Position in the implicit tree
+ * @param next Next sorted bid to place
+ */
+void FrozenBidIndex::layout(size_t k, size_t& next) {
+	if (k > bids.size())
+		return;
+	layout(2 * k, next);
+	key_prefixes[k] = keyPrefix(bids[next].bidId);
+	sorted_rank[k] = (uint32_t)next;
+	next++;
+	layout(2 * k + 1, next);
+}
+
+/**
+ * Find a bid by id
+ *
+ * @param bidId The bid id to search for
+ * @return The stored bid, or nullptr if not found
+ */
+const Bid* FrozenBidIndex::Find(std::string_view bidId) const {
+	uint64_t prefix = keyPrefix(bidId);
+	size_t size = bids.size();
+	const uint64_t* keys = key_prefixes.data();
+
+	//Walk down, going right whenever the key there is smaller. The comparison becomes a flag added to the index, not a branch.
+	size_t k = 1;
+	while (k <= size) {
+		if (16 * k <= size) {
+			prefetch(keys + 16 * k);
+			prefetch(keys + min(16 * k + 8, size));
+		}
+		k = 2 * k + (keys[k] < prefix);
+	}
+
+	//Undo the final run of right turns, which leaves the first position whose key is not smaller (0 if there is none).
+	k >>= std::countr_one(k) + 1;
+	if (k == 0)
+		return nullptr;
+
+	//Every bid sharing the prefix is next to this one in key order. For ids of 8 characters or fewer there is only the one.
+	for (size_t i = sorted_rank[k]; i < size && keyPrefix(bids[i].bidId) == prefix; i++) {
+		if (bids[i].bidId == bidId)
+			return &bids[i];
+	}
+	return nullptr;
+}
+
+/**
+ * Search for a bid by id
  */
-BinarySearchTree::BinarySearchTree() {
-	root = new Node();
+Bid FrozenBidIndex::Search(string bidId) const {
+	const Bid* found = Find(bidId);
+	return found ? *found : Bid();
 }
 
 /**
- * Destructor
+ * Number of bids in the index
  */
-BinarySearchTree::~BinarySearchTree() {
-    // recurse from root deleting every node
-
-	//Just delete root, and root's destructor handles deleting the children.
-	delete root;
+size_t FrozenBidIndex::Size() const {
+	return bids.size();
 }
 
+/**
+ * Take a read-only snapshot of the tree. The tree is left
+ * unchanged, and later changes to it do not show in the snapshot.
+ */
+FrozenBidIndex BinarySearchTree::Freeze() {
+	vector<Bid> sorted;
+	sorted.reserve(Size());
 
+	//The range comes out in id order, so the bids are already sorted.
+	for (const Bid& bid : Range()) {
+		sorted.push_back(bid);
+	}
+	return FrozenBidIndex(std::move(sorted));
+}
 
 
 
 
 
+//============================================================================
+// Persistent Bid Tree class definition
+//============================================================================
 
+//Internal structure for a persistent tree node. Once published, a node is never changed, only replaced.
+struct PersistentNode;
+typedef shared_ptr< const PersistentNode > PersistentLink;
 
-
+struct PersistentNode : std::enable_shared_from_this< PersistentNode > {
+	Bid bid_data;
+	PersistentLink left_child_node;
+	PersistentLink right_child_node;
+	int height;
+	size_t subtree_size;
+};
 
 /**
- * Insert a bid into a node, and add it to the binary search tree.
+ * Define a class containing data members and methods to
+ * implement a point-in-time, read-only view of a PersistentBidTree.
+ *
+ * A snapshot is just a counted reference to one version's root.
+ * Nothing it can reach is ever changed, so any number of threads
+ * may read it without locks while the tree moves on, and the nodes
+ * of that version are freed when the last snapshot holding them
+ * goes away.
  */
-void BinarySearchTree::Insert(Bid bid) {
-    // Implement inserting a bid into the tree
+class BidSnapshot {
 
-	//First check if the root node has bid data.
-	if (root && root->bid_data.amount == 0) {
-		root->bid_data = bid;
-		return;
-	}
+private:
 
-	//Otherwise, if the root already has bid data, recursively call addNode to add it to a leaf.
-	else
-		addNode(root, bid);
-}
+	//Root of the version this snapshot sees, empty for an empty tree.
+	PersistentLink root;
 
+public:
+	BidSnapshot();
+	explicit BidSnapshot(PersistentLink root);
+	const Bid* Find(std::string_view bidId) const;		//The stored bid, or nullptr if not found.
+	Bid Search(string bidId) const;					//A copy of the bid, or an empty bid if not found.
+	size_t Size() const;								//Number of bids in this version.
+	template <typename Visitor>
+	void InOrder(Visitor visit) const;					//Call visit(const Bid&) for every bid, in key order.
+};
 
+/**
+ * Default constructor, a snapshot of an empty tree
+ */
+BidSnapshot::BidSnapshot() {
+}
 
+/**
+ * Snapshot of the version with the given root
+ */
+BidSnapshot::BidSnapshot(PersistentLink root) : root(std::move(root)) {
+}
 
 /**
- * Add a bid to some node (recursive)
+ * Find a bid by id
  *
- * @param node Current node in tree
- * @param bid Bid to be added
+ * @param bidId The bid id to search for
+ * @return The stored bid, valid for as long as this snapshot, or nullptr if not found
  */
-void BinarySearchTree::addNode(Node* node, Bid bid) {
-	// FIXME (2b) Implement inserting a bid into the tree
-
-	//Check if the new bid would go to the left or the right of the given node.
-	if (node->bid_data.bidId > bid.bidId) {
-
-		//Check if there is a left child node already. If so, recursively call addNode on it. Otherwise, create it with the new bid.
-		if (node->left_child_node)
-			addNode(node->left_child_node, bid);
-		else {
-			node->left_child_node = new Node();
-			node->left_child_node->bid_data = bid;
-		}
+const Bid* BidSnapshot::Find(std::string_view bidId) const {
+	const PersistentNode* node = root.get();
+	while (node != NULL) {
+		if (node->bid_data.bidId == bidId)
+			return &node->bid_data;
+		node = bidId < node->bid_data.bidId ? node->left_child_node.get() : node->right_child_node.get();
+	}
+	return nullptr;
+}
 
-	} 
+/**
+ * Search for a bid by id
+ */
+Bid BidSnapshot::Search(string bidId) const {
+	const Bid* found = Find(bidId);
+	return found ? *found : Bid();
+}
 
-	//Otherwise, it goes on the right if it's equal or greater.
-	else {
+/**
+ * Number of bids in this version
+ */
+size_t BidSnapshot::Size() const {
+	return root ? root->subtree_size : 0;
+}
 
-		//Check if there is a right child node already. If so, recursively call addNode on it. Otherwise, create it with the new bid.
-		if (node->right_child_node)
-			addNode(node->right_child_node, bid);
-		else {
-			node->right_child_node = new Node();
-			node->right_child_node->bid_data = bid;
+/**
+ * Visit every bid in key order, with an explicit stack
+ *
+ * @param visit Called with each bid
+ */
+template <typename Visitor>
+void BidSnapshot::InOrder(Visitor visit) const {
+	vector<const PersistentNode*> stack;
+	const PersistentNode* node = root.get();
+	while (node != NULL || !stack.empty()) {
+		while (node != NULL) {
+			stack.push_back(node);
+			node = node->left_child_node.get();
 		}
+		node = stack.back();
+		stack.pop_back();
+		visit(node->bid_data);
+		node = node->right_child_node.get();
 	}
-
 }
 
-
-
-
 /**
- * Remove a bid
+ * Define a class containing data members and methods to
+ * implement a persistent (path copying) self-balancing tree of bids.
+ *
+ * An insert or remove never touches a published node. It copies
+ * the nodes on the path from the root down to the change, sharing
+ * every untouched sub-tree with the previous version, rebalances
+ * the copies (AVL), and only then publishes the new root with one
+ * atomic store of a raw pointer. Writers are serialized with a
+ * mutex that readers never take.
+ *
+ * Readers take a BidSnapshot, and never see a version part way
+ * through a rotation. The root is published as a plain pointer,
+ * not an std::atomic<shared_ptr>, which libstdc++ guards with a
+ * spinlock. A reader names the root it loaded in a hazard slot,
+ * checks it is still the root, and only then takes a counted
+ * reference to it, so taking a snapshot is a few atomic operations
+ * and never waits on the writer. The writer keeps each replaced
+ * root alive until no hazard slot names it.
  */
-void BinarySearchTree::Remove(string bidId) {
+class PersistentBidTree {
+
+private:
 
-	//Recursively call removeNode and it will handle finding and removing the proper node.
-	root = removeNode(root, bidId);
+	//A reader's claim on a root it is about to take a reference to.
+	struct alignas(64) HazardSlot {
+		std::atomic< bool > claimed{ false };
+		std::atomic< const PersistentNode* > node{ nullptr };
+	};
 
-}
+	//Root of the latest version, as readers see it.
+	std::atomic< const PersistentNode* > root;
 
+	//The writers' own reference to the latest version, and replaced versions a reader may still be taking.
+	PersistentLink latest;
+	vector< PersistentLink > retired;
 
+	//Serializes writers, so no update is lost to another built from the same version.
+	mutable std::mutex writer;
 
+	mutable HazardSlot hazards[SNAPSHOT_HAZARD_SLOTS];
 
+	//Private helper function used to publish a version, with the writer mutex held.
+	void publish(PersistentLink version);
 
-Node* BinarySearchTree::removeNode(Node* root, string bidId) {
+	//Private helper functions used to build new versions, recursing to the height of the tree only.
+	static int nodeHeight(const PersistentLink& node);
+	static size_t nodeSize(const PersistentLink& node);
+	static PersistentLink makeNode(const Bid& bid, PersistentLink left, PersistentLink right);
+	static PersistentLink balance(const Bid& bid, PersistentLink left, PersistentLink right);
+	static PersistentLink addNode(const PersistentLink& node, const Bid& bid);
+	static PersistentLink removeNode(const PersistentLink& node, const string& bidId, bool& removed);
+	static PersistentLink removeMin(const PersistentLink& node, Bid& min);
 
-	//Passed an empty node. 
-	if (root == NULL) return root;
+public:
+	PersistentBidTree();
+	void Insert(Bid bid);							//Publish a version with the bid added.
+	void Remove(string bidId);						//Publish a version with the bid removed.
+	Bid Search(string bidId) const;				//Search the latest version.
+	size_t Size() const;							//Number of bids in the latest version.
+	BidSnapshot Snapshot() const;					//The latest version, for as long as the snapshot is held.
+};
 
-	//First, check if the key is less than or greater than the current node's value. Setting root to the returned value of removeNode rebuilds the tree properly after a 
-	//node is removed.
+/**
+ * Default constructor, an empty tree
+ */
+PersistentBidTree::PersistentBidTree() : root(nullptr) {
+}
 
-	//Left side
-	if (root->bid_data.bidId > bidId)
-		root->left_child_node = removeNode(root->left_child_node, bidId);
+/**
+ * Make a version the latest, then let go of every replaced version
+ * no reader is in the middle of taking
+ *
+ * @param version Root of the new version
+ */
+void PersistentBidTree::publish(PersistentLink version) {
+	root.store(version.get());
+	retired.push_back(std::move(latest));
+	latest = std::move(version);
+
+	//A reader that named a retired root before the store above is seen here; one that names it after finds it is no longer the root.
+	vector<const PersistentNode*> guarded;
+	for (const HazardSlot& slot : hazards) {
+		const PersistentNode* node = slot.node.load();
+		if (node != nullptr)
+			guarded.push_back(node);
+	}
+	std::erase_if(retired, [&guarded](const PersistentLink& version) {
+		return find(guarded.begin(), guarded.end(), version.get()) == guarded.end();
+	});
+}
 
-	//Right node.
-	else if (root->bid_data.bidId < bidId)
-		root->right_child_node = removeNode(root->right_child_node, bidId);
+/**
+ * Height and size of a sub-tree that may be missing
+ */
+int PersistentBidTree::nodeHeight(const PersistentLink& node) {
+	return node ? node->height : 0;
+}
 
+size_t PersistentBidTree::nodeSize(const PersistentLink& node) {
+	return node ? node->subtree_size : 0;
+}
 
+/**
+ * A new node over two existing sub-trees
+ */
+PersistentLink PersistentBidTree::makeNode(const Bid& bid, PersistentLink left, PersistentLink right) {
+	auto node = make_shared<PersistentNode>();
+	node->bid_data = bid;
+	node->height = 1 + max(nodeHeight(left), nodeHeight(right));
+	node->subtree_size = 1 + nodeSize(left) + nodeSize(right);
+	node->left_child_node = std::move(left);
+	node->right_child_node = std::move(right);
+	return node;
+}
 
-	//Last, check if the root node is the node to be removed.
-	else if (root->bid_data.bidId == bidId) {
+/**
+ * A new node over two sub-trees whose heights differ by at most two,
+ * rotated back into AVL balance. The rotations build new nodes
+ * rather than relinking the old ones, which may be in a snapshot.
+ */
+PersistentLink PersistentBidTree::balance(const Bid& bid, PersistentLink left, PersistentLink right) {
+	int leftHeight = nodeHeight(left);
+	int rightHeight = nodeHeight(right);
+
+	//Left heavy. Lift the left child, or the left child's right child when that is the taller side (double rotation).
+	if (leftHeight > rightHeight + 1) {
+		if (nodeHeight(left->left_child_node) >= nodeHeight(left->right_child_node))
+			return makeNode(left->bid_data, left->left_child_node, makeNode(bid, left->right_child_node, std::move(right)));
+		const PersistentLink& pivot = left->right_child_node;
+		return makeNode(pivot->bid_data, makeNode(left->bid_data, left->left_child_node, pivot->left_child_node), makeNode(bid, pivot->right_child_node, std::move(right)));
+	}
 
-		//First, check whether this node has 2, 1 or no children.
-		if (root->left_child_node && root->right_child_node) {
+	//Right heavy, the mirror image.
+	if (rightHeight > leftHeight + 1) {
+		if (nodeHeight(right->right_child_node) >= nodeHeight(right->left_child_node))
+			return makeNode(right->bid_data, makeNode(bid, std::move(left), right->left_child_node), right->right_child_node);
+		const PersistentLink& pivot = right->left_child_node;
+		return makeNode(pivot->bid_data, makeNode(bid, std::move(left), pivot->left_child_node), makeNode(right->bid_data, pivot->right_child_node, right->right_child_node));
+	}
 
-			//Find the lowest value in the right sub-tree and set it as the new root.
-			Node* temp_node = root->right_child_node;
-			while (temp_node != NULL) {
-				temp_node = temp_node->left_child_node;
-			}
+	return makeNode(bid, std::move(left), std::move(right));
+}
 
-			//Set the root's data to the temp nodes, and delete the old node replacing the root.
-			root->bid_data = temp_node->bid_data;
-			removeNode(root->right_child_node, temp_node->bid_data.bidId);
+/**
+ * Copy of a sub-tree with a bid added. As in BinarySearchTree, an equal id goes on the right.
+ */
+PersistentLink PersistentBidTree::addNode(const PersistentLink& node, const Bid& bid) {
+	if (!node)
+		return makeNode(bid, NULL, NULL);
+	if (node->bid_data.bidId > bid.bidId)
+		return balance(node->bid_data, addNode(node->left_child_node, bid), node->right_child_node);
+	return balance(node->bid_data, node->left_child_node, addNode(node->right_child_node, bid));
+}
 
-		}
+/**
+ * Copy of a sub-tree without its lowest bid, which is handed back in min
+ */
+PersistentLink PersistentBidTree::removeMin(const PersistentLink& node, Bid& min) {
+	if (!node->left_child_node) {
+		min = node->bid_data;
+		return node->right_child_node;
+	}
+	return balance(node->bid_data, removeMin(node->left_child_node, min), node->right_child_node);
+}
 
-		//Otherwise, check for a left child node only.
-		else if (root->left_child_node == NULL) {
-			//Left child node is returned and set to parents new child.
-			Node* temp_node = root->right_child_node;
-			delete root;
-			return temp_node;
-		}
+/**
+ * Copy of a sub-tree with a bid removed
+ *
+ * @param removed Set when the bid was found. When it is not, the sub-tree is returned as it was, with nothing copied.
+ */
+PersistentLink PersistentBidTree::removeNode(const PersistentLink& node, const string& bidId, bool& removed) {
+	if (!node)
+		return node;
 
-		//Otherwise, check for a right child node only.
-		else if (root->right_child_node == NULL) {
-			Node* temp_node = root->left_child_node;
-			delete root;
-			return temp_node;
-		}
+	if (node->bid_data.bidId > bidId) {
+		PersistentLink left = removeNode(node->left_child_node, bidId, removed);
+		return removed ? balance(node->bid_data, std::move(left), node->right_child_node) : node;
 	}
-	
-	//Return root node, if not returned anywhere else and no children to replace root.
-	return root;
+	if (node->bid_data.bidId < bidId) {
+		PersistentLink right = removeNode(node->right_child_node, bidId, removed);
+		return removed ? balance(node->bid_data, node->left_child_node, std::move(right)) : node;
+	}
+
+	//Found it. With two children, the lowest bid of the right sub-tree takes its place, otherwise the one child does.
+	removed = true;
+	if (!node->left_child_node)
+		return node->right_child_node;
+	if (!node->right_child_node)
+		return node->left_child_node;
+	Bid successor;
+	PersistentLink right = removeMin(node->right_child_node, successor);
+	return balance(successor, node->left_child_node, std::move(right));
 }
 
+/**
+ * Add a bid, and publish the new version
+ */
+void PersistentBidTree::Insert(Bid bid) {
+	lock_guard<mutex> lock(writer);
+	publish(addNode(latest, bid));
+}
 
+/**
+ * Remove a bid, and publish the new version. Nothing is published when the bid is not found.
+ */
+void PersistentBidTree::Remove(string bidId) {
+	lock_guard<mutex> lock(writer);
+	bool removed = false;
+	PersistentLink updated = removeNode(latest, bidId, removed);
+	if (removed)
+		publish(std::move(updated));
+}
 
 /**
- * Search for a bid
+ * Search the latest version for a bid
  */
-Bid BinarySearchTree::Search(string bidId) {
+Bid PersistentBidTree::Search(string bidId) const {
+	return Snapshot().Search(bidId);
+}
 
-	//Call the recursive search function, using the root node as a starting point.
-	return Search(root, bidId);
+/**
+ * Number of bids in the latest version
+ */
+size_t PersistentBidTree::Size() const {
+	return Snapshot().Size();
 }
 
+/**
+ * The latest version. It stays readable, and unchanged, for as
+ * long as the snapshot is held, however the tree changes after.
+ */
+BidSnapshot PersistentBidTree::Snapshot() const {
+
+	//Claim a hazard slot, starting from one picked by thread so readers rarely try the same one.
+	size_t index = hash<thread::id>()(this_thread::get_id()) % SNAPSHOT_HAZARD_SLOTS;
+	while (hazards[index].claimed.load(memory_order_relaxed) || hazards[index].claimed.exchange(true, memory_order_acquire)) {
+		index = (index + 1) % SNAPSHOT_HAZARD_SLOTS;
+	}
+	HazardSlot& slot = hazards[index];
+
+	//Name the root, then check it is still the root, so the writer cannot have dropped it before seeing the name.
+	const PersistentNode* node = root.load();
+	while (true) {
+		slot.node.store(node);
+		const PersistentNode* current = root.load();
+		if (current == node)
+			break;
+		node = current;
+	}
+
+	PersistentLink version = node != nullptr ? node->shared_from_this() : PersistentLink();
+	slot.node.store(nullptr, memory_order_release);
+	slot.claimed.store(false, memory_order_release);
+	return BidSnapshot(std::move(version));
+}
 
 
 
-//Overloaded search function used to take advantage of recursion, making searching much simpler.
-Bid BinarySearchTree::Search(Node* node, string bidId) {
 
-	//The bid structure to return.
-	Bid bid;
 
-	//Check to see if the parent node passed is the matching node.
-	if (node->bid_data.bidId == bidId)
-		bid = node->bid_data;
+//============================================================================
+// Static methods used for testing
+//============================================================================
 
-	//Otherwise, if the bidId is less than the node's value, check the left side of the tree.
-	else if (node->left_child_node && node->left_child_node->bid_data.bidId > bidId)
-		bid = Search(node->left_child_node, bidId);
+/**
+ * Display the bid information to the console (std::out)
+ *
+ * @param bid struct containing the bid info
+ */
+void displayBid(const Bid& bid) {
+    cout << bid.bidId << ": " << bid.title << " | " << bid.amount << " | "
+            << bid.fund << '\n';
+    return;
+}
 
-	//Lastly, if neither of the above, check the right of the tree.
-	else if (node->right_child_node && node->right_child_node->bid_data.bidId > bidId)
-		bid = Search(node->right_child_node, bidId);
+/**
+ * Make a bid from a row of the CSV file. Only the four columns a
+ * bid keeps are copied out of the mapping.
+ */
+Bid bidFromRow(const CsvRow& row) {
+    Bid bid;
+    bid.bidId = row.Text(1);
+    bid.title = row.Text(0);
+    bid.fund = row.Text(8);
+    bid.amount = row.Number(4, '$');
+    return bid;
+}
 
-	return bid;
+/**
+ * Add the bid in a row of the CSV file to a batch, skipping a row
+ * too short to hold one
+ */
+void appendBidRow(const CsvRow& row, vector<Bid>& batch) {
+    if (row.Size() >= 9) {
+        batch.push_back(bidFromRow(row));
+    }
 }
 
+/**
+ * Load a CSV file containing bids into a container. The file is
+ * split into a chunk of rows per thread, and each thread converts
+ * its chunk into a batch of bids. The batches are joined in file
+ * order and the tree is built from them in one pass.
+ *
+ * @param csvPath the path to the CSV file to load
+ * @param bst the tree to load into
+ * @param amounts optional index to add every bid's amount to
+ * @param threadCount number of threads to convert rows on, including the caller
+ */
+void loadBids(string csvPath, BinarySearchTree* bst, AmountIndex* amounts = NULL, unsigned int threadCount = 1) {
+    cout << "Loading CSV file " << csvPath << endl;
+
+    // map the file rather than parse it into strings up front
+    MappedCsv file(csvPath);
+    if (!file.IsOpen()) {
+        std::cerr << "Unable to open " << csvPath << std::endl;
+        return;
+    }
 
+    // read and display header row - optional
+    CsvRow header;
+    size_t offset = 0;
+    file.ReadRow(offset, header);
+    for (size_t c = 0; c < header.Size(); c++) {
+        cout << header.Text(c) << " | ";
+    }
+    cout << "" << endl;
 
+    vector< vector<Bid> > batches = file.ReadBatches<Bid>(threadCount, appendBidRow);
 
+    // the first batch becomes the vector, the others move onto its end
+    size_t total = 0;
+    for (const vector<Bid>& batch : batches) {
+        total += batch.size();
+    }
+    vector<Bid> bids = std::move(batches[0]);
+    bids.reserve(total);
+    for (size_t i = 1; i < batches.size(); i++) {
+        bids.insert(bids.end(), make_move_iterator(batches[i].begin()), make_move_iterator(batches[i].end()));
+    }
 
+    if (amounts != NULL) {
+        for (const Bid& bid : bids) {
+            amounts->Insert(bid);
+        }
+    }
 
+    // build the whole tree in one pass instead of inserting row by row
+    bst->BulkLoad(std::move(bids));
+}
 
+/**
+ * Read a CSV file containing bids into a vector, in file order
+ *
+ * @param csvPath the path to the CSV file to load
+ * @return a vector holding all the bids read
+ */
+vector<Bid> readBids(string csvPath) {
+    vector<Bid> bids;
 
+    MappedCsv file(csvPath);
+    if (!file.IsOpen()) {
+        std::cerr << "Unable to open " << csvPath << std::endl;
+        return bids;
+    }
 
+    bids.reserve(file.EstimateRows());
+    file.ForEachRow([&](const CsvRow& row) {
+        if (row.Size() >= 9) {
+            bids.push_back(bidFromRow(row));
+        }
+    });
+    return bids;
+}
 
+/**
+ * Load the bids into a new tree with loadBids on 1, 2, 4 and 8
+ * threads, and report rows and bytes read per second for each
+ *
+ * @param csvPath the path to the CSV file to load
+ */
+void benchmarkLoad(string csvPath) {
+    size_t fileBytes = MappedCsv(csvPath).Size();
+    for (unsigned int threadCount : { 1, 2, 4, 8 }) {
+        BinarySearchTree bst(true);
 
+        auto start = chrono::steady_clock::now();
+        loadBids(csvPath, &bst, NULL, threadCount);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
+        cout << "threads: " << threadCount << " | rows/sec: " << (unsigned long long)(bst.Size() / seconds)
+             << " | GB/s: " << fileBytes / seconds / 1e9 << endl;
+    }
+}
 
 /**
- * Traverse the tree in order
+ * Display the order statistics of the loaded bids
+ *
+ * @param bst the tree of bids
+ * @param amounts the index of their amounts
+ * @param bidKey the bid id to report the rank of
  */
-void BinarySearchTree::InOrder() {
-	//If this is being called on the root node, start calling the private, recursive helper function.
-	if (root)
-		inOrder(root);
+void displayStatistics(BinarySearchTree* bst, AmountIndex* amounts, string bidKey) {
+    cout << "bids: " << bst->Size() << " | total amount: " << bst->SumRange("", "\xff") << endl;
+    cout << "rank of bid " << bidKey << ": " << bst->Rank(bidKey) << endl;
+    cout << "median amount: " << amounts->Percentile(50) << endl;
+    cout << "p99 amount: " << amounts->Percentile(99) << endl;
+    for (size_t k = 1; k <= 3 && k <= amounts->Size(); k++) {
+        cout << "highest bid #" << k << ": " << amounts->KthHighest(k) << endl;
+    }
 }
 
+/**
+ * Read just the bid ids from a CSV file, to use as search keys
+ *
+ * @param csvPath the path to the CSV file to load
+ * @return every bid id in file order
+ */
+vector<string> loadBidIds(string csvPath) {
+    vector<string> bidIds;
+    MappedCsv file(csvPath);
+    file.ForEachRow([&](const CsvRow& row) {
+        if (row.Size() > 1) {
+            bidIds.push_back(row.Text(1));
+        }
+    });
+    return bidIds;
+}
 
+/**
+ * Look up every bid id in the file one at a time with Search,
+ * then again in one call to SearchMany, and report both times.
+ *
+ * @param csvPath the path to the CSV file the tree was loaded from
+ * @param bst the loaded tree
+ */
+void benchmarkSearchMany(string csvPath, BinarySearchTree* bst) {
+    vector<string> bidIds = loadBidIds(csvPath);
+    vector<string_view> keys(bidIds.begin(), bidIds.end());
+    vector<const Bid*> results(keys.size());
+
+    auto start = chrono::steady_clock::now();
+    size_t found = 0;
+    for (const string& bidId : bidIds) {
+        if (!bst->Search(bidId).bidId.empty()) {
+            found++;
+        }
+    }
+    double searchSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
+    start = chrono::steady_clock::now();
+    bst->SearchMany(keys, results);
+    double batchSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-void BinarySearchTree::inOrder(Node* node) {
+    cout << found << " of " << keys.size() << " bids found" << endl;
+    cout << "Search:     " << searchSeconds << " seconds" << endl;
+    cout << "SearchMany: " << batchSeconds << " seconds" << endl;
+}
 
-	//Display nodes on the left, then the root, followed by the right.
-	if (node != NULL) {
-		inOrder(node->left_child_node);
-		displayBid(node->bid_data);
-		inOrder(node->right_child_node);
-	}
+/**
+ * Build a plain tree, a self-balancing tree and a bulk loaded
+ * tree from the bids in sorted, reverse sorted and shuffled
+ * order, and report the insert time, resulting height and time
+ * to search every bid for each.
+ *
+ * @param csvPath the path to the CSV file to load
+ */
+void benchmarkBalancing(string csvPath) {
+    vector<Bid> sorted = readBids(csvPath);
+    sort(sorted.begin(), sorted.end(), [](const Bid& a, const Bid& b) { return a.bidId < b.bidId; });
 
-}
+    vector<Bid> reversed(sorted.rbegin(), sorted.rend());
 
+    vector<Bid> shuffled = sorted;
+    shuffle(shuffled.begin(), shuffled.end(), mt19937(179));
 
+    const pair<const char*, vector<Bid>*> orders[] = { { "sorted", &sorted }, { "reverse", &reversed }, { "shuffled", &shuffled } };
+    for (const auto& order : orders) {
+        for (bool selfBalancing : { false, true }) {
+            BinarySearchTree tree(selfBalancing);
 
+            auto start = chrono::steady_clock::now();
+            for (const Bid& bid : *order.second) {
+                tree.Insert(bid);
+            }
+            double insertSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
+            start = chrono::steady_clock::now();
+            for (const Bid& bid : *order.second) {
+                tree.Search(bid.bidId);
+            }
+            double searchSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-//============================================================================
-// Static methods used for testing
-//============================================================================
+            cout << order.first << (selfBalancing ? " | AVL      " : " | plain    ")
+                 << " | height: " << tree.Height()
+                 << " | insert: " << insertSeconds << " seconds"
+                 << " | search: " << searchSeconds << " seconds" << endl;
+        }
 
-/**
- * Display the bid information to the console (std::out)
- *
- * @param bid struct containing the bid info
- */
-void displayBid(Bid bid) {
-    cout << bid.bidId << ": " << bid.title << " | " << bid.amount << " | "
-            << bid.fund << endl;
-    return;
+        // the same bids bulk loaded, the load time includes sorting them
+        BinarySearchTree tree(true);
+        vector<Bid> copy = *order.second;
+        auto start = chrono::steady_clock::now();
+        tree.BulkLoad(std::move(copy));
+        double loadSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        start = chrono::steady_clock::now();
+        for (const Bid& bid : *order.second) {
+            tree.Search(bid.bidId);
+        }
+        double searchSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << order.first << " | bulk load"
+             << " | height: " << tree.Height()
+             << " | insert: " << loadSeconds << " seconds"
+             << " | search: " << searchSeconds << " seconds" << endl;
+    }
 }
 
 /**
- * Load a CSV file containing bids into a container
+ * Load the bids into a self-balancing tree and a B+ tree, then
+ * time searching every bid in each, and a full ordered scan of
+ * the B+ tree through its leaf links.
  *
  * @param csvPath the path to the CSV file to load
- * @return a container holding all the bids read
  */
-void loadBids(string csvPath, BinarySearchTree* bst) {
-    cout << "Loading CSV file " << csvPath << endl;
+void benchmarkBPlusTree(string csvPath) {
+    vector<Bid> bids = readBids(csvPath);
+    BinarySearchTree bst(true);
+    BPlusTree bPlusTree;
+
+    auto start = chrono::steady_clock::now();
+    for (const Bid& bid : bids) {
+        bst.Insert(bid);
+    }
+    double bstInsertSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    for (const Bid& bid : bids) {
+        bPlusTree.Insert(bid);
+    }
+    double bPlusInsertSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-    // initialize the CSV Parser using the given path
-    csv::Parser file = csv::Parser(csvPath);
+    start = chrono::steady_clock::now();
+    for (const Bid& bid : bids) {
+        bst.Search(bid.bidId);
+    }
+    double bstSearchSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-    // read and display header row - optional
-    vector<string> header = file.getHeader();
-    for (auto const& c : header) {
-        cout << c << " | ";
+    start = chrono::steady_clock::now();
+    for (const Bid& bid : bids) {
+        bPlusTree.Search(bid.bidId);
     }
-    cout << "" << endl;
+    double bPlusSearchSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // sum the amounts so the scan has something to do with each bid
+    double total = 0;
+    size_t scanned = 0;
+    start = chrono::steady_clock::now();
+    bPlusTree.Range("", "\xff", [&](const Bid& bid) {
+        total += bid.amount;
+        scanned++;
+    });
+    double scanSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "AVL insert: " << bstInsertSeconds << " seconds | search: " << bstSearchSeconds << " seconds" << endl;
+    cout << "B+  insert: " << bPlusInsertSeconds << " seconds | search: " << bPlusSearchSeconds << " seconds" << endl;
+    cout << "B+  scan of " << scanned << " bids totalling " << total << ": " << scanSeconds << " seconds" << endl;
+}
 
-    try {
-        // loop to read rows of a CSV file
-        for (unsigned int i = 0; i < file.rowCount(); i++) {
+/**
+ * Build trees of synthetic bids at 1, 10 and 100 million keys (up
+ * to the size asked for), freeze each one, and time the same
+ * random searches against the pointer based tree and the frozen
+ * Eytzinger snapshot. Only the bid id is filled in, and even so
+ * the tree needs well over 100 bytes per key, so check the memory
+ * on the host before going to 100 million.
+ */
+void benchmarkFrozenIndex() {
+    size_t maxMillions = 1;
+    cout << "Largest size to test, in millions of keys (1, 10 or 100): ";
+    cin >> maxMillions;
+
+    const size_t searchCount = 1000000;
+    for (size_t millions = 1; millions <= maxMillions; millions *= 10) {
+        size_t count = millions * 1000000;
+
+        // distinct 8 character hex ids, scrambled so neighbouring ids are not neighbouring keys
+        vector<Bid> bids(count);
+        for (size_t i = 0; i < count; i++) {
+            char id[9];
+            snprintf(id, sizeof(id), "%08x", (uint32_t)(i * 2654435761u));
+            bids[i].bidId = id;
+        }
+        vector<string> keys;
+        mt19937 random(179);
+        for (size_t i = 0; i < searchCount; i++) {
+            keys.push_back(bids[random() % count].bidId);
+        }
 
-            // Create a data structure and add to the collection of bids
-            Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][8];
-            bid.amount = strToDouble(file[i][4], '$');
+        BinarySearchTree tree(true);
+        tree.BulkLoad(std::move(bids));
+        FrozenBidIndex frozen = tree.Freeze();
 
-            //cout << "Item: " << bid.title << ", Fund: " << bid.fund << ", Amount: " << bid.amount << endl;
+        size_t found = 0;
+        auto start = chrono::steady_clock::now();
+        for (const string& key : keys) {
+            found += !tree.Search(key).bidId.empty();
+        }
+        double treeSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-            // push this bid to the end
-            bst->Insert(bid);
+        start = chrono::steady_clock::now();
+        for (const string& key : keys) {
+            found += frozen.Find(key) != nullptr;
         }
-    } catch (csv::Error &e) {
-        std::cerr << e.what() << std::endl;
+        double frozenSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << count << " keys | " << found << " found"
+             << " | tree: " << treeSeconds << " seconds"
+             << " | frozen: " << frozenSeconds << " seconds" << endl;
     }
 }
 
 /**
- * Simple C function to convert a string to a double
- * after stripping out unwanted char
+ * Ingest the bids into a persistent tree on one thread while
+ * reader threads keep taking snapshots. Each reader walks every
+ * snapshot in full, checking it is sorted and holds exactly the
+ * number of bids its root says, then searches it for random bids.
+ * The ingest time is compared with plain AVL inserts, which is the
+ * cost of the path copying.
  *
- * credit: http://stackoverflow.com/a/24875936
+ * @param csvPath the path to the CSV file to load
+ */
+void benchmarkSnapshots(string csvPath) {
+    vector<Bid> bids = readBids(csvPath);
+    if (bids.empty()) {
+        return;
+    }
+
+    BinarySearchTree bst(true);
+    auto start = chrono::steady_clock::now();
+    for (const Bid& bid : bids) {
+        bst.Insert(bid);
+    }
+    double bstSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    const unsigned int readerCount = 4;
+    PersistentBidTree tree;
+    atomic<bool> done(false);
+    atomic<size_t> snapshots(0), searches(0), inconsistent(0);
+
+    vector<thread> readers;
+    for (unsigned int r = 0; r < readerCount; r++) {
+        readers.emplace_back([&, r]() {
+            mt19937 random(179 + r);
+            while (!done.load()) {
+                BidSnapshot snapshot = tree.Snapshot();
+                size_t count = 0;
+                string previous;
+                bool sorted = true;
+                snapshot.InOrder([&](const Bid& bid) {
+                    sorted = sorted && previous <= bid.bidId;
+                    previous = bid.bidId;
+                    count++;
+                });
+                if (!sorted || count != snapshot.Size()) {
+                    inconsistent++;
+                }
+                for (int i = 0; i < 1000; i++) {
+                    snapshot.Find(bids[random() % bids.size()].bidId);
+                }
+                snapshots++;
+                searches += 1000;
+            }
+        });
+    }
+
+    // insert everything, then remove every other bid, publishing a version each time
+    start = chrono::steady_clock::now();
+    for (const Bid& bid : bids) {
+        tree.Insert(bid);
+    }
+    for (size_t i = 0; i < bids.size(); i += 2) {
+        tree.Remove(bids[i].bidId);
+    }
+    double ingestSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    done = true;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+
+    cout << "AVL insert: " << bstSeconds << " seconds" << endl;
+    cout << "persistent insert + remove: " << ingestSeconds << " seconds, " << (bids.size() + (bids.size() + 1) / 2) << " versions, " << tree.Size() << " bids left" << endl;
+    cout << readerCount << " readers: " << snapshots << " snapshots walked, " << searches / ingestSeconds << " searches/s, "
+         << inconsistent << " inconsistent" << endl;
+}
+
+/**
+ * Ask for a range of bid ids, then scan it through the lazy range
+ * view and report the number of bids, their total amount and the
+ * time taken. The bids are read in place, nothing is printed per
+ * row, so this runs at the speed of the tree walk itself.
  *
- * @param ch The character to strip out
+ * @param bst the loaded tree
  */
-double strToDouble(string str, char ch) {
-	//str.erase(remove(str.begin(), str.end(), ch), str.end());
-    return atof(str.c_str());
+void rangeQuery(BinarySearchTree* bst) {
+    string lo, hi;
+    cout << "Lowest bid id: ";
+    cin >> lo;
+    cout << "Highest bid id: ";
+    cin >> hi;
+
+    auto start = chrono::steady_clock::now();
+    size_t count = 0;
+    double total = 0;
+    for (double amount : bst->Range(lo, hi) | views::transform(&Bid::amount)) {
+        total += amount;
+        count++;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << count << " bids from " << lo << " to " << hi << " totalling " << total << endl;
+    cout << "time: " << seconds << " seconds" << endl;
 }
 
 /**
@@ -414,8 +2627,9 @@ int main(int argc, char* argv[]) {
     // Define a timer variable
     clock_t ticks;
 
-    // Define a binary search tree to hold all bids
-    BinarySearchTree* bst;
+    // Define a binary search tree to hold all bids, and an index of their amounts
+    BinarySearchTree* bst = NULL;
+    AmountIndex* amounts = NULL;
 
     Bid bid;
 
@@ -426,22 +2640,34 @@ int main(int argc, char* argv[]) {
         cout << "  2. Display All Bids" << endl;
         cout << "  3. Find Bid" << endl;
         cout << "  4. Remove Bid" << endl;
+        cout << "  5. Batched Search Benchmark" << endl;
+        cout << "  6. Balancing Benchmark" << endl;
+        cout << "  7. B+ Tree Benchmark" << endl;
+        cout << "  8. Bid Statistics" << endl;
         cout << "  9. Exit" << endl;
+        cout << "  10. Frozen Index Benchmark" << endl;
+        cout << "  11. Snapshot Benchmark" << endl;
+        cout << "  12. Range Query" << endl;
+        cout << "  13. Load Benchmark" << endl;
         cout << "Enter choice: ";
         cin >> choice;
 
         switch (choice) {
 
         case 1:
-            bst = new BinarySearchTree();
+            // a reload replaces the tree and the index, so free the ones it replaces
+            delete bst;
+            delete amounts;
+            bst = new BinarySearchTree(true);
+            amounts = new AmountIndex();
 
             // Initialize a timer variable before loading bids
             ticks = clock();
 
             // Complete the method call to load the bids
-            loadBids(csvPath, bst);
+            loadBids(csvPath, bst, amounts, max(thread::hardware_concurrency(), 1u));
 
-            //cout << bst->Size() << " bids read" << endl;
+            cout << bst->Size() << " bids read" << endl;
 
             // Calculate elapsed time and display result
             ticks = clock() - ticks; // current clock ticks minus starting clock ticks
@@ -472,11 +2698,51 @@ int main(int argc, char* argv[]) {
             break;
 
         case 4:
+            // the amount index is keyed on the amount, so look the bid up first
+            bid = bst->Search(bidKey);
+            if (!bid.bidId.empty()) {
+                amounts->Remove(bid);
+            }
             bst->Remove(bidKey);
             break;
+
+        case 5:
+            benchmarkSearchMany(csvPath, bst);
+            break;
+
+        case 6:
+            benchmarkBalancing(csvPath);
+            break;
+
+        case 7:
+            benchmarkBPlusTree(csvPath);
+            break;
+
+        case 8:
+            displayStatistics(bst, amounts, bidKey);
+            break;
+
+        case 10:
+            benchmarkFrozenIndex();
+            break;
+
+        case 11:
+            benchmarkSnapshots(csvPath);
+            break;
+
+        case 12:
+            rangeQuery(bst);
+            break;
+
+        case 13:
+            benchmarkLoad(csvPath);
+            break;
         }
     }
 
+    delete bst;
+    delete amounts;
+
     cout << "Good bye." << endl;
 
 	return 0;
@@ -8,12 +8,30 @@
 //============================================================================
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
 #include <climits>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <mutex>
+#include <ranges>
+#include <shared_mutex>
+#include <span>
 #include <string> // atoi
+#include <string_view>
+#include <thread>
 #include <time.h>
+#include <vector>
 
-#include "CSVparser.hpp"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HASHTABLE_USE_SSE2 1
+#endif
+
+#include "MappedCsv.hpp"
 
 using namespace std;
 
@@ -21,11 +39,39 @@ using namespace std;
 // Global definitions visible to all methods and classes
 //============================================================================
 
-const unsigned int DEFAULT_SIZE = 179;
+//Number of control bytes probed at once, one SSE2 register worth.
+const unsigned int GROUP_WIDTH = 16;
+
+//Initial number of slots in the table. Must be a power of two, and a multiple of GROUP_WIDTH.
+const unsigned int DEFAULT_SIZE = 256;
+
+//Control byte markers. A full slot stores the 7 bit fingerprint of its key (0 - 127), so both markers have the high bit set.
+const int8_t CTRL_EMPTY = -128;
+const int8_t CTRL_DELETED = -2;
+
+//Highest fraction of slots that may be full or deleted before the table grows.
+const double MAX_LOAD_FACTOR = 0.875;
+
+//Number of groups moved from the old slot table to the new one on each Insert or Remove while a resize is in progress.
+const unsigned int MIGRATE_GROUPS = 2;
+
+//Number of independently locked shards in a ShardedHashTable. A power of two so the shard can be picked from the top bits of the hash.
+const unsigned int SHARD_COUNT = 64;
+
+//Number of keys SearchMany hashes and prefetches together before probing any of them.
+const unsigned int SEARCH_BATCH = 16;
 
-// forward declarations
-double strToDouble(string str, char ch);
+//Number of bids a BidQueue holds. Producers wait when it is full. A power of two.
+const size_t INGEST_QUEUE_CAPACITY = 4096;
 
+//Most bids the consumer of a pipelined load drains from the queue at a time.
+const size_t INGEST_BATCH = 256;
+
+//Seed for hashing bid ids. Any fixed value works, it only has to be the same for every call.
+const uint64_t HASH_SEED = 0x5EEDB1D5ull;
+
+//Returned by the slot lookups when no slot holds the key.
+const size_t NO_SLOT = SIZE_MAX;
 
 // define a structure to hold bid information
 struct Bid {
@@ -38,7 +84,7 @@ struct Bid {
     }
 };
 
-void displayBid(Bid bid);
+void displayBid(const Bid& bid);
 
 
 //============================================================================
@@ -47,31 +93,142 @@ void displayBid(Bid bid);
 
 /**
  * Define a class containing data members and methods to
- * implement a hash table with chaining.
+ * implement a hash table with open addressing.
+ *
+ * The layout follows the "Swiss table" design: a flat array of one byte
+ * control words holds a 7 bit fingerprint of each key, and lookups compare
+ * a whole group of 16 control bytes at a time (with SSE2 where available)
+ * before touching any bid. Slots hold only an index into a dense array of
+ * bids, so probing never drags whole Bid structs through the cache.
  */
 class HashTable {
 
 private:
 
-	//2D vector used to store the data of the hash table.
-	std::vector< std::vector< Bid > > m_bids;
-	
+	//One generation of the probe arrays. While the table is resizing it holds two of these, and bids move from the old one to the new one a few groups at a time.
+	struct SlotTable {
+
+		//Control bytes, one per slot. Holds the fingerprint of the key stored in the slot, or CTRL_EMPTY / CTRL_DELETED.
+		std::vector< int8_t > control;
+
+		//Slots, parallel to control. Each full slot holds the index of its bid in m_bids.
+		std::vector< uint32_t > slots;
+
+		//Number of slots currently marked CTRL_DELETED. These still count against the load of the table.
+		size_t deleted = 0;
+	};
+
+	//Slot table that new bids are inserted into.
+	SlotTable m_table;
+
+	//Slot table being drained during a resize. Empty when no resize is in progress.
+	SlotTable m_oldTable;
+
+	//Next group of m_oldTable to move into m_table.
+	size_t m_migrateGroup;
+
+	//Dense storage of the bids themselves. Removing a bid moves the last bid into the hole so this never has gaps.
+	std::vector< Bid > m_bids;
+
+	//Full hash of each bid id, parallel to m_bids. Computed once on insert so resizing and key comparisons never hash again.
+	std::vector< uint64_t > m_hashes;
+
 	//Function used to generate a hash value for each piece of data stored in the hash table.
-    unsigned int hash(int key);
+    static uint64_t hash(std::string_view key);
+
+	//Helper functions used to probe the slot tables.
+	size_t findSlot(const SlotTable& table, std::string_view bidId, uint64_t hashValue) const;
+	size_t findInsertSlot(const SlotTable& table, uint64_t hashValue) const;
+	SlotTable* locate(std::string_view bidId, uint64_t hashValue, size_t& slot);
+	void prefetchProbe(const SlotTable& table, uint64_t hashValue) const;
+
+	//Helper functions used to resize the table incrementally.
+	static size_t capacityFor(size_t count);
+	void startResize(size_t newCapacity);
+	void migrateStep(size_t groups);
+
+	//The operations themselves, given a hash that has already been computed.
+	void insert(Bid bid, uint64_t hashValue);
+	void remove(std::string_view bidId, uint64_t hashValue);
+	const Bid* find(std::string_view bidId, uint64_t hashValue);
+
+	//The sharded table hashes once to pick a shard, then hands the same hash to the shard's table.
+	friend class ShardedHashTable;
 
 public:
     HashTable();
     virtual ~HashTable();
     void Insert(Bid bid);
     void PrintAll();
+    std::span<const Bid> Bids() const;
+    auto Range(string lo, string hi) const;
     void Remove(string bidId);
+    void Reserve(size_t count);
     Bid Search(string bidId);
+    void SearchMany(std::span<const std::string_view> bidIds, std::span<const Bid*> results);
+    size_t Size();
 };
 
+/**
+ * Ask the CPU to start loading a cache line that will be read soon
+ *
+ * @param address Any address in the line
+ */
+static inline void prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_prefetch(address);
+#elif defined(HASHTABLE_USE_SSE2)
+	_mm_prefetch((const char*)address, _MM_HINT_T0);
+#endif
+}
+
+/**
+ * Bit mask of the positions in a group of control bytes equal to value
+ *
+ * @param group The first control byte of the group
+ * @param value The control byte to look for
+ * @return One bit per matching position, lowest bit first
+ */
+static inline uint32_t matchGroup(const int8_t* group, int8_t value) {
+#ifdef HASHTABLE_USE_SSE2
+	__m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(value)));
+#else
+	uint32_t mask = 0;
+	for (unsigned int i = 0; i < GROUP_WIDTH; i++) {
+		if (group[i] == value)
+			mask |= 1u << i;
+	}
+	return mask;
+#endif
+}
+
+/**
+ * Bit mask of the positions in a group that are empty or deleted
+ *
+ * @param group The first control byte of the group
+ * @return One bit per free position, lowest bit first
+ */
+static inline uint32_t matchFree(const int8_t* group) {
+#ifdef HASHTABLE_USE_SSE2
+	//Only the markers have the high bit set, so the sign bits are exactly the free slots.
+	return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group)));
+#else
+	uint32_t mask = 0;
+	for (unsigned int i = 0; i < GROUP_WIDTH; i++) {
+		if (group[i] < 0)
+			mask |= 1u << i;
+	}
+	return mask;
+#endif
+}
+
 /**
  * Default constructor
  */
-HashTable::HashTable() : m_bids(DEFAULT_SIZE) {
+HashTable::HashTable() : m_migrateGroup(0) {
+	m_table.control.assign(DEFAULT_SIZE, CTRL_EMPTY);
+	m_table.slots.assign(DEFAULT_SIZE, 0);
 }
 
 /**
@@ -79,45 +236,340 @@ HashTable::HashTable() : m_bids(DEFAULT_SIZE) {
  */
 HashTable::~HashTable() {
 	m_bids.clear();
+	m_hashes.clear();
+}
+
+/**
+ * Read 8 or 4 bytes of a key as a little endian integer
+ */
+static inline uint64_t read64(const char* p) {
+	uint64_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline uint64_t read32(const char* p) {
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
 }
 
 /**
  * Calculate the hash value of a given key.
- * Note that key is specifically defined as
- * unsigned int to prevent undefined results
- * of a negative list index.
+ * This is xxHash64 (https://github.com/Cyan4973/xxHash),
+ * run straight over the bytes of the bid id.
+ * The low 7 bits become the fingerprint stored in the
+ * control bytes, and the rest pick the group to start
+ * probing at, so both ends need to be well mixed.
  *
  * @param key The key to hash
  * @return The calculated hash
  */
-unsigned int HashTable::hash(int key) {
+uint64_t HashTable::hash(std::string_view key) {
+	const uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+	const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+	const uint64_t PRIME3 = 0x165667B19E3779F9ull;
+	const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ull;
+	const uint64_t PRIME5 = 0x27D4EB2F165667C5ull;
+
+	auto round = [&](uint64_t accumulator, uint64_t input) {
+		accumulator += input * PRIME2;
+		return std::rotl(accumulator, 31) * PRIME1;
+	};
+
+	const char* p = key.data();
+	const char* end = p + key.size();
+	uint64_t h;
+
+	//Long keys are consumed 32 bytes at a time across four independent lanes.
+	if (key.size() >= 32) {
+		uint64_t v1 = HASH_SEED + PRIME1 + PRIME2;
+		uint64_t v2 = HASH_SEED + PRIME2;
+		uint64_t v3 = HASH_SEED;
+		uint64_t v4 = HASH_SEED - PRIME1;
+		for (; p + 32 <= end; p += 32) {
+			v1 = round(v1, read64(p));
+			v2 = round(v2, read64(p + 8));
+			v3 = round(v3, read64(p + 16));
+			v4 = round(v4, read64(p + 24));
+		}
+		h = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+		for (uint64_t lane : { v1, v2, v3, v4 }) {
+			h ^= round(0, lane);
+			h = h * PRIME1 + PRIME4;
+		}
+	}
+	else
+		h = HASH_SEED + PRIME5;
+
+	h += key.size();
+
+	//Fold in the tail, which is the whole key for typical bid ids.
+	for (; p + 8 <= end; p += 8) {
+		h ^= round(0, read64(p));
+		h = std::rotl(h, 27) * PRIME1 + PRIME4;
+	}
+	if (p + 4 <= end) {
+		h ^= read32(p) * PRIME1;
+		h = std::rotl(h, 23) * PRIME2 + PRIME3;
+		p += 4;
+	}
+	for (; p < end; p++) {
+		h ^= (uint8_t)*p * PRIME5;
+		h = std::rotl(h, 11) * PRIME1;
+	}
+
+	//Final avalanche.
+	h ^= h >> 33;
+	h *= PRIME2;
+	h ^= h >> 29;
+	h *= PRIME3;
+	h ^= h >> 32;
+	return h;
+}
+
+/**
+ * Find the slot holding a bid id in one slot table
+ *
+ * @param table The slot table to probe
+ * @param bidId The bid id to search for
+ * @param hashValue The hash of the bid id
+ * @return The slot index, or NO_SLOT if the bid is not in the table
+ */
+size_t HashTable::findSlot(const SlotTable& table, std::string_view bidId, uint64_t hashValue) const {
+	if (table.control.empty())
+		return NO_SLOT;
+
+	size_t groupMask = table.control.size() / GROUP_WIDTH - 1;
+	size_t group = (hashValue >> 7) & groupMask;
+	int8_t fingerprint = (int8_t)(hashValue & 0x7F);
+
+	//Triangular probing over the groups. With a power of two group count this visits every group once.
+	for (size_t step = 1; step <= groupMask + 1; step++) {
+		const int8_t* control = &table.control[group * GROUP_WIDTH];
+
+		//Only look at the positions whose fingerprint matched, and only compare key bytes once the whole cached hash matches too.
+		for (uint32_t matches = matchGroup(control, fingerprint); matches != 0; matches &= matches - 1) {
+			size_t slot = group * GROUP_WIDTH + std::countr_zero(matches);
+			uint32_t index = table.slots[slot];
+			if (m_hashes[index] == hashValue && m_bids[index].bidId == bidId)
+				return slot;
+		}
+
+		//An empty slot ends the probe sequence, the key would have been placed here.
+		if (matchGroup(control, CTRL_EMPTY) != 0)
+			return NO_SLOT;
+
+		group = (group + step) & groupMask;
+	}
+	return NO_SLOT;
+}
+
+/**
+ * Find the first empty or deleted slot along the probe sequence of a hash
+ *
+ * @param table The slot table to probe
+ * @param hashValue The hash of the key being inserted
+ * @return The slot index
+ */
+size_t HashTable::findInsertSlot(const SlotTable& table, uint64_t hashValue) const {
+	size_t groupMask = table.control.size() / GROUP_WIDTH - 1;
+	size_t group = (hashValue >> 7) & groupMask;
+
+	//The load factor is capped below 1, so there is always a free slot somewhere along the sequence.
+	for (size_t step = 1; ; step++) {
+		uint32_t free = matchFree(&table.control[group * GROUP_WIDTH]);
+		if (free != 0)
+			return group * GROUP_WIDTH + std::countr_zero(free);
+		group = (group + step) & groupMask;
+	}
+}
+
+/**
+ * Find the slot holding a bid id in whichever slot table has it
+ *
+ * @param bidId The bid id to search for
+ * @param hashValue The hash of the bid id
+ * @param slot Set to the slot index when found
+ * @return The slot table holding the bid, or nullptr if not found
+ */
+HashTable::SlotTable* HashTable::locate(std::string_view bidId, uint64_t hashValue, size_t& slot) {
+	slot = findSlot(m_table, bidId, hashValue);
+	if (slot != NO_SLOT)
+		return &m_table;
+
+	//Bids not migrated yet are still in the old table.
+	slot = findSlot(m_oldTable, bidId, hashValue);
+	if (slot != NO_SLOT)
+		return &m_oldTable;
+
+	return nullptr;
+}
+
+/**
+ * Smallest capacity that holds a number of bids under MAX_LOAD_FACTOR
+ *
+ * @param count Number of bids
+ * @return Number of slots, a power of two multiple of GROUP_WIDTH
+ */
+size_t HashTable::capacityFor(size_t count) {
+	size_t capacity = GROUP_WIDTH;
+	while (count > capacity * MAX_LOAD_FACTOR)
+		capacity *= 2;
+	return capacity;
+}
+
+/**
+ * Begin moving the bids into a fresh slot table. Only the
+ * probe arrays are rebuilt, the bids themselves never move.
+ *
+ * @param newCapacity Number of slots, a power of two multiple of GROUP_WIDTH
+ */
+void HashTable::startResize(size_t newCapacity) {
+
+	//Should a resize still be running, finish it first so there are never more than two generations.
+	if (!m_oldTable.control.empty())
+		migrateStep(SIZE_MAX);
+
+	m_oldTable = std::move(m_table);
+	m_table = SlotTable();
+	m_table.control.assign(newCapacity, CTRL_EMPTY);
+	m_table.slots.assign(newCapacity, 0);
+	m_migrateGroup = 0;
+}
+
+/**
+ * Move some groups of the old slot table into the current one
+ *
+ * @param groups The number of groups to move
+ */
+void HashTable::migrateStep(size_t groups) {
+	if (m_oldTable.control.empty())
+		return;
+
+	size_t groupCount = m_oldTable.control.size() / GROUP_WIDTH;
+	for (; groups > 0 && m_migrateGroup < groupCount; groups--, m_migrateGroup++) {
+		for (size_t slot = m_migrateGroup * GROUP_WIDTH; slot < (m_migrateGroup + 1) * GROUP_WIDTH; slot++) {
+			if (m_oldTable.control[slot] < 0)
+				continue;
+
+			uint32_t index = m_oldTable.slots[slot];
+			uint64_t hashValue = m_hashes[index];
+			size_t newSlot = findInsertSlot(m_table, hashValue);
+			if (m_table.control[newSlot] == CTRL_DELETED)
+				m_table.deleted--;
+			m_table.control[newSlot] = (int8_t)(hashValue & 0x7F);
+			m_table.slots[newSlot] = index;
 
-	//Use the modulus function using the key and the default size of the table.
-	return key % DEFAULT_SIZE;
+			//Tombstone rather than empty, so bids later in the old probe sequence can still be found.
+			m_oldTable.control[slot] = CTRL_DELETED;
+		}
+	}
+
+	//Everything has been moved, release the old generation.
+	if (m_migrateGroup == groupCount)
+		m_oldTable = SlotTable();
 }
 
 /**
- * Insert a bid
+ * Size the table to hold a number of bids without growing.
+ * Call before loading a known number of rows so the load
+ * never pays for a resize.
+ *
+ * @param count The number of bids expected
+ */
+void HashTable::Reserve(size_t count) {
+	size_t capacity = capacityFor(count);
+	if (capacity <= m_table.control.size())
+		return;
+
+	//Reserving is an explicit request, so do the whole move now rather than spreading it over later inserts.
+	startResize(capacity);
+	migrateStep(SIZE_MAX);
+}
+
+/**
+ * Insert a bid. A bid with the same id already in the
+ * table is replaced.
  *
  * @param bid The bid to insert
  */
 void HashTable::Insert(Bid bid) {
-	
+
 	//Get the hash value for this bid.
-	unsigned int hash_value = hash(strToDouble(bid.bidId, ' '));
-	m_bids[hash_value].push_back(bid);
+	uint64_t hash_value = hash(bid.bidId);
+	insert(std::move(bid), hash_value);
+}
+
+/**
+ * Insert a bid under an already computed hash
+ *
+ * @param bid The bid to insert
+ * @param hash_value The hash of the bid id
+ */
+void HashTable::insert(Bid bid, uint64_t hash_value) {
+	migrateStep(MIGRATE_GROUPS);
+
+	size_t slot;
+	SlotTable* table = locate(bid.bidId, hash_value, slot);
+	if (table != nullptr) {
+		m_bids[table->slots[slot]] = std::move(bid);
+		return;
+	}
+
+	//Every live bid ends up in the current table, so count them all against its load. Grow only if live bids are the reason, otherwise just clear out the tombstones.
+	size_t capacity = m_table.control.size();
+	if (m_bids.size() + m_table.deleted + 1 > capacity * MAX_LOAD_FACTOR) {
+		if (m_bids.size() + 1 > capacity * MAX_LOAD_FACTOR / 2)
+			startResize(capacity * 2);
+		else
+			startResize(capacity);
+		migrateStep(MIGRATE_GROUPS);
+	}
+
+	slot = findInsertSlot(m_table, hash_value);
+	if (m_table.control[slot] == CTRL_DELETED)
+		m_table.deleted--;
+	m_table.control[slot] = (int8_t)(hash_value & 0x7F);
+	m_table.slots[slot] = (uint32_t)m_bids.size();
+	m_bids.push_back(std::move(bid));
+	m_hashes.push_back(hash_value);
 }
 
 /**
  * Print all bids
  */
 void HashTable::PrintAll() {
-	for (std::vector< std::vector< Bid > >::iterator containerIter = m_bids.begin(); containerIter != m_bids.end(); containerIter++) {
-		for (std::vector< Bid >::iterator bidIter = containerIter->begin(); bidIter != containerIter->end(); containerIter++) {
-			displayBid(*bidIter);
-		}
+	for (const Bid& bid : Bids()) {
+		displayBid(bid);
 	}
-	
+
+	//Flush once at the end rather than after every row.
+	cout.flush();
+}
+
+/**
+ * Every bid, in storage order. The bids are contiguous, so this is
+ * a plain array scan. Inserting or removing bids invalidates it.
+ */
+std::span<const Bid> HashTable::Bids() const {
+	return m_bids;
+}
+
+/**
+ * Lazy view of the bids with an id from lo to hi inclusive. The
+ * table keeps no key order, so this filters the dense bid array
+ * and yields the matching bids in storage order, by const
+ * reference, without copying them. Inserting or removing bids
+ * invalidates it.
+ *
+ * @param lo Lowest bid id in range
+ * @param hi Highest bid id in range
+ */
+auto HashTable::Range(string lo, string hi) const {
+	return Bids() | std::views::filter([lo = std::move(lo), hi = std::move(hi)](const Bid& bid) {
+		return lo <= bid.bidId && bid.bidId <= hi;
+	});
 }
 
 /**
@@ -128,47 +580,363 @@ void HashTable::PrintAll() {
 void HashTable::Remove(string bidId) {
 
 	//Generate the hash value to find the appropriate bid.
-	unsigned int hashValue = hash(strToDouble(bidId, ' '));
-
-	//Loop through the entries at the hashValue set of values in the hash table.
-	for (std::vector< Bid >::iterator bidIter = m_bids[hashValue].begin(); bidIter != m_bids[hashValue].end(); bidIter++) {
-		if (bidIter->bidId == bidId) {
-
-			//Found the matching value, erase the bid and break from the loop.
-			m_bids[hashValue].erase(bidIter);
-			break;
-		}
-	}
+	remove(bidId, hash(bidId));
 }
 
 /**
- * Search for the specified bidId
+ * Remove a bid under an already computed hash
  *
  * @param bidId The bid id to search for
+ * @param hashValue The hash of the bid id
  */
-Bid HashTable::Search(string bidId) {
+void HashTable::remove(std::string_view bidId, uint64_t hashValue) {
+	migrateStep(MIGRATE_GROUPS);
+
+	size_t slot;
+	SlotTable* table = locate(bidId, hashValue, slot);
+	if (table == nullptr)
+		return;
+
+	//Leave a tombstone so probe sequences running through this slot are not cut short.
+	uint32_t index = table->slots[slot];
+	table->control[slot] = CTRL_DELETED;
+	table->deleted++;
+
+	//Fill the hole in the bid storage with the last bid, and point that bid's slot at its new index.
+	uint32_t last = (uint32_t)m_bids.size() - 1;
+	if (index != last) {
+		size_t lastSlot;
+		SlotTable* lastTable = locate(m_bids[last].bidId, m_hashes[last], lastSlot);
+		lastTable->slots[lastSlot] = index;
+		m_bids[index] = std::move(m_bids[last]);
+		m_hashes[index] = m_hashes[last];
+	}
+	m_bids.pop_back();
+	m_hashes.pop_back();
+}
 
-	//Default bid value to return if no value is found in the hash table.
+/**
+ * The bid Search returns when no bid has the id searched for
+ */
+static Bid notFoundBid() {
     Bid bid;
 	bid.amount = -1;
 	bid.bidId = "Not Found";
 	bid.fund = "Not Found";
 	bid.title = "Not Found";
+	return bid;
+}
+
+/**
+ * Search for the specified bidId
+ *
+ * @param bidId The bid id to search for
+ */
+Bid HashTable::Search(string bidId) {
+
+	//Find the slot for the bid ID, if there is one.
+	const Bid* found = find(bidId, hash(bidId));
+	return found != nullptr ? *found : notFoundBid();
+}
+
+/**
+ * Find a bid under an already computed hash. Searching never
+ * moves bids between slot tables, so concurrent finds are safe
+ * as long as nothing is inserting or removing.
+ *
+ * @param bidId The bid id to search for
+ * @param hashValue The hash of the bid id
+ * @return The stored bid, or nullptr if not found
+ */
+const Bid* HashTable::find(std::string_view bidId, uint64_t hashValue) {
+	size_t slot;
+	SlotTable* table = locate(bidId, hashValue, slot);
+	if (table == nullptr)
+		return nullptr;
+	return &m_bids[table->slots[slot]];
+}
+
+/**
+ * Prefetch the first group a hash probes in a slot table
+ *
+ * @param table The slot table that will be probed
+ * @param hashValue The hash of the key
+ */
+void HashTable::prefetchProbe(const SlotTable& table, uint64_t hashValue) const {
+	if (table.control.empty())
+		return;
+	size_t group = (hashValue >> 7) & (table.control.size() / GROUP_WIDTH - 1);
+	prefetch(&table.control[group * GROUP_WIDTH]);
+	prefetch(&table.slots[group * GROUP_WIDTH]);
+}
 
-	//Find the hash value for the bid ID.
-	unsigned int bidHashValue = hash(strToDouble(bidId, ' '));
-	
-	//Check the index at the hash value where the bid would have been stored.
-	if (!m_bids[bidHashValue].empty()) {
-		for (std::vector< Bid >::iterator bidIter = m_bids[bidHashValue].begin(); bidIter != m_bids[bidHashValue].end(); bidIter++ ) {
-			if (bidIter->bidId == bidId) {
-				bid = *bidIter;
-				break;
+/**
+ * Search for many bid ids at once. The keys are handled in
+ * batches of SEARCH_BATCH: every key in a batch is hashed and
+ * its probe group prefetched, then the candidate bids for every
+ * key are prefetched, and only then is each key probed. The
+ * cache misses of a whole batch overlap instead of being paid
+ * one after another.
+ *
+ * @param bidIds The bid ids to search for
+ * @param results Receives a pointer to each stored bid, or nullptr if not found. Must be as long as bidIds. The pointers are valid until the table is next changed.
+ */
+void HashTable::SearchMany(std::span<const std::string_view> bidIds, std::span<const Bid*> results) {
+	uint64_t hashes[SEARCH_BATCH];
+
+	for (size_t begin = 0; begin < bidIds.size(); begin += SEARCH_BATCH) {
+		size_t count = std::min<size_t>(SEARCH_BATCH, bidIds.size() - begin);
+
+		//Stage one, hash every key and start loading its control bytes and slots.
+		for (size_t i = 0; i < count; i++) {
+			hashes[i] = hash(bidIds[begin + i]);
+			prefetchProbe(m_table, hashes[i]);
+			prefetchProbe(m_oldTable, hashes[i]);
+		}
+
+		//Stage two, the control bytes have arrived, so start loading the cached hash and bid of the first fingerprint match.
+		size_t groupMask = m_table.control.size() / GROUP_WIDTH - 1;
+		for (size_t i = 0; i < count; i++) {
+			size_t group = (hashes[i] >> 7) & groupMask;
+			uint32_t matches = matchGroup(&m_table.control[group * GROUP_WIDTH], (int8_t)(hashes[i] & 0x7F));
+			if (matches != 0) {
+				uint32_t index = m_table.slots[group * GROUP_WIDTH + std::countr_zero(matches)];
+				prefetch(&m_hashes[index]);
+				prefetch(&m_bids[index]);
 			}
 		}
+
+		//Stage three, probe for real. Most of what this touches is in cache by now.
+		for (size_t i = 0; i < count; i++) {
+			results[begin + i] = find(bidIds[begin + i], hashes[i]);
+		}
 	}
+}
 
-    return bid;
+/**
+ * Returns the number of bids in the table
+ */
+size_t HashTable::Size() {
+	return m_bids.size();
+}
+
+//============================================================================
+// Sharded Hash Table class definition
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement a thread safe hash table.
+ *
+ * The bids are split across SHARD_COUNT independent HashTables,
+ * each behind its own reader/writer lock. The top bits of the
+ * hash pick the shard, and the shard's table probes with the
+ * low bits of the same hash. Searches only take a shared lock,
+ * so readers never block each other, and a writer only blocks
+ * the readers of the one shard it is changing.
+ */
+class ShardedHashTable {
+
+private:
+
+	//A shard is padded out to its own cache lines so the locks of neighbouring shards do not false share.
+	struct alignas(64) Shard {
+		std::shared_mutex lock;
+		HashTable table;
+	};
+
+	std::array< Shard, SHARD_COUNT > m_shards;
+
+	//Shard that a hash belongs to.
+	Shard& shardFor(uint64_t hashValue);
+
+public:
+    void Insert(Bid bid);
+    void Remove(string bidId);
+    void Reserve(size_t count);
+    Bid Search(string bidId);
+    size_t Size();
+};
+
+/**
+ * Shard that a hash belongs to
+ *
+ * @param hashValue The hash of a bid id
+ */
+ShardedHashTable::Shard& ShardedHashTable::shardFor(uint64_t hashValue) {
+	return m_shards[hashValue >> (64 - std::countr_zero(SHARD_COUNT))];
+}
+
+/**
+ * Insert a bid, replacing a bid with the same id
+ *
+ * @param bid The bid to insert
+ */
+void ShardedHashTable::Insert(Bid bid) {
+	uint64_t hashValue = HashTable::hash(bid.bidId);
+	Shard& shard = shardFor(hashValue);
+
+	std::unique_lock<std::shared_mutex> guard(shard.lock);
+	shard.table.insert(std::move(bid), hashValue);
+}
+
+/**
+ * Remove a bid
+ *
+ * @param bidId The bid id to remove
+ */
+void ShardedHashTable::Remove(string bidId) {
+	uint64_t hashValue = HashTable::hash(bidId);
+	Shard& shard = shardFor(hashValue);
+
+	std::unique_lock<std::shared_mutex> guard(shard.lock);
+	shard.table.remove(bidId, hashValue);
+}
+
+/**
+ * Size every shard to hold its share of a number of bids
+ *
+ * @param count The number of bids expected across all shards
+ */
+void ShardedHashTable::Reserve(size_t count) {
+
+	//Allow some slack over an even split, the shards never fill exactly evenly.
+	size_t perShard = count / SHARD_COUNT + count / (SHARD_COUNT * 8) + 1;
+	for (Shard& shard : m_shards) {
+		std::unique_lock<std::shared_mutex> guard(shard.lock);
+		shard.table.Reserve(perShard);
+	}
+}
+
+/**
+ * Search for the specified bidId
+ *
+ * @param bidId The bid id to search for
+ * @return A copy of the bid, or the same "Not Found" bid as HashTable::Search
+ */
+Bid ShardedHashTable::Search(string bidId) {
+	uint64_t hashValue = HashTable::hash(bidId);
+	Shard& shard = shardFor(hashValue);
+
+	//The copy has to be made while the lock is held, a writer could move the stored bid as soon as it is released.
+	std::shared_lock<std::shared_mutex> guard(shard.lock);
+	const Bid* found = shard.table.find(bidId, hashValue);
+	return found != nullptr ? *found : notFoundBid();
+}
+
+/**
+ * Returns the number of bids across all shards
+ */
+size_t ShardedHashTable::Size() {
+	size_t size = 0;
+	for (Shard& shard : m_shards) {
+		std::shared_lock<std::shared_mutex> guard(shard.lock);
+		size += shard.table.Size();
+	}
+	return size;
+}
+
+//============================================================================
+// Bid Queue class definition
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement a bounded multi-producer, single-consumer queue of bids.
+ *
+ * The queue is a ring of cells, each with a sequence number saying
+ * whose turn it is: a producer may fill the cell for ticket t when
+ * its sequence is t, and the consumer may empty it when it is
+ * t + 1. A producer claims its ticket with a single fetch_add on
+ * the tail, so producers never retry or wait on each other; the
+ * only time one waits is when the queue is full and its cell has
+ * not been drained yet. The consumer owns the head outright, so it
+ * needs no atomic operation to advance it. The tail, the head and
+ * every cell sit on cache lines of their own, so producers and the
+ * consumer do not false share.
+ *
+ * The consumer takes bids in ticket order, so a producer that has
+ * claimed a ticket but not yet filled its cell holds back the bids
+ * behind it until it does.
+ */
+class BidQueue {
+
+private:
+
+	struct alignas(64) Cell {
+		std::atomic< uint64_t > sequence;
+		Bid bid;
+	};
+
+	//The ring. Its size is a power of two so a ticket maps to a cell with a mask.
+	std::vector< Cell > m_cells;
+	uint64_t m_mask;
+
+	//Next ticket to hand to a producer.
+	alignas(64) std::atomic< uint64_t > m_tail;
+
+	//Next ticket the consumer will read. Only the consumer touches it.
+	alignas(64) uint64_t m_head;
+
+public:
+	explicit BidQueue(size_t capacity);
+	void Push(Bid bid);
+	size_t PopBatch(std::vector< Bid >& out, size_t maxCount);
+};
+
+/**
+ * Create an empty queue
+ *
+ * @param capacity Number of bids the queue holds, rounded up to a power of two
+ */
+BidQueue::BidQueue(size_t capacity) : m_cells(std::bit_ceil(std::max<size_t>(capacity, 2))), m_tail(0), m_head(0) {
+	m_mask = m_cells.size() - 1;
+	for (size_t i = 0; i < m_cells.size(); i++) {
+		m_cells[i].sequence.store(i, memory_order_relaxed);
+	}
+}
+
+/**
+ * Add a bid to the queue. Safe to call from any number of threads at once.
+ *
+ * @param bid The bid to add
+ */
+void BidQueue::Push(Bid bid) {
+	uint64_t ticket = m_tail.fetch_add(1, memory_order_relaxed);
+	Cell& cell = m_cells[ticket & m_mask];
+
+	//Only waits when the queue is full, until the consumer drains the bid from one lap ago.
+	while (cell.sequence.load(memory_order_acquire) != ticket) {
+		this_thread::yield();
+	}
+
+	cell.bid = std::move(bid);
+	cell.sequence.store(ticket + 1, memory_order_release);
+}
+
+/**
+ * Take the bids that are ready off the front of the queue. Only
+ * the one consumer thread may call this.
+ *
+ * @param out The bids are appended to it
+ * @param maxCount Most bids to take
+ * @return Number of bids taken, 0 if the next one is not ready
+ */
+size_t BidQueue::PopBatch(std::vector< Bid >& out, size_t maxCount) {
+	size_t count = 0;
+	while (count < maxCount) {
+		Cell& cell = m_cells[m_head & m_mask];
+		if (cell.sequence.load(memory_order_acquire) != m_head + 1)
+			break;
+
+		out.push_back(std::move(cell.bid));
+
+		//Hand the cell to the producer one lap ahead.
+		cell.sequence.store(m_head + m_cells.size(), memory_order_release);
+		m_head++;
+		count++;
+	}
+	return count;
 }
 
 //============================================================================
@@ -180,63 +948,366 @@ Bid HashTable::Search(string bidId) {
  *
  * @param bid struct containing the bid info
  */
-void displayBid(Bid bid) {
+void displayBid(const Bid& bid) {
     cout << bid.bidId << ": " << bid.title << " | " << bid.amount << " | "
-            << bid.fund << endl;
+            << bid.fund << '\n';
     return;
 }
 
 /**
- * Load a CSV file containing bids into a container
+ * Make a bid from a row of the CSV file. Only the four columns a
+ * bid keeps are copied out of the mapping.
+ */
+Bid bidFromRow(const CsvRow& row) {
+    Bid bid;
+    bid.bidId = row.Text(1);
+    bid.title = row.Text(0);
+    bid.fund = row.Text(8);
+    bid.amount = row.Number(4, '$');
+    return bid;
+}
+
+/**
+ * Add the bid in a row of the CSV file to a batch, skipping a row
+ * too short to hold one
+ */
+void appendBidRow(const CsvRow& row, vector<Bid>& batch) {
+    if (row.Size() >= 9) {
+        batch.push_back(bidFromRow(row));
+    }
+}
+
+/**
+ * Load a CSV file containing bids into a container. The file is
+ * split into a chunk of rows per thread, and each thread converts
+ * its chunk into a batch of bids. The calling thread then inserts
+ * the batches in file order, so a later row with the same id still
+ * replaces an earlier one.
  *
  * @param csvPath the path to the CSV file to load
- * @return a container holding all the bids read
+ * @param hashTable the HashTable or ShardedHashTable to load into
+ * @param threadCount number of threads to convert rows on, including the caller
  */
-void loadBids(string csvPath, HashTable* hashTable) {
+template <typename Table>
+void loadBids(string csvPath, Table* hashTable, unsigned int threadCount = 1) {
     cout << "Loading CSV file " << csvPath << endl;
 
-    // initialize the CSV Parser using the given path
-    csv::Parser file = csv::Parser(csvPath);
+    // map the file rather than parse it into strings up front
+    MappedCsv file(csvPath);
+    if (!file.IsOpen()) {
+        std::cerr << "Unable to open " << csvPath << std::endl;
+        return;
+    }
 
     // read and display header row - optional
-    vector<string> header = file.getHeader();
-    for (auto const& c : header) {
-        cout << c << " | ";
+    CsvRow header;
+    size_t offset = 0;
+    file.ReadRow(offset, header);
+    for (size_t c = 0; c < header.Size(); c++) {
+        cout << header.Text(c) << " | ";
     }
     cout << "" << endl;
 
-    try {
-        // loop to read rows of a CSV file
-        for (unsigned int i = 0; i < file.rowCount(); i++) {
+    // size the table for every row up front so loading never resizes
+    hashTable->Reserve(file.EstimateRows());
+
+    for (vector<Bid>& batch : file.ReadBatches<Bid>(threadCount, appendBidRow)) {
+        for (Bid& bid : batch) {
+            hashTable->Insert(std::move(bid));
+        }
+    }
+}
+
+/**
+ * Load a CSV file containing bids into a container, converting the
+ * rows to bids on several producer threads, each over its own chunk
+ * of rows, that push them through a BidQueue. The calling thread is the only one that touches the
+ * table: it drains the queue in batches and inserts them, so the
+ * table needs no locking.
+ *
+ * @param csvPath the path to the CSV file to load
+ * @param hashTable the HashTable or ShardedHashTable to load into
+ * @param producerCount number of threads converting rows
+ */
+template <typename Table>
+void loadBidsPipelined(string csvPath, Table* hashTable, unsigned int producerCount) {
+
+    // map the file and split it into a chunk of rows per producer
+    MappedCsv file(csvPath);
+    if (!file.IsOpen()) {
+        std::cerr << "Unable to open " << csvPath << std::endl;
+        return;
+    }
+    producerCount = max(producerCount, 1u);
+    vector<size_t> bounds = file.SplitRows(producerCount);
+    hashTable->Reserve(file.EstimateRows());
+
+    BidQueue queue(INGEST_QUEUE_CAPACITY);
+    atomic<unsigned int> producersDone(0);
+
+    // each producer converts its own chunk of the rows
+    vector<thread> producers;
+    for (unsigned int t = 0; t < producerCount; t++) {
+        producers.emplace_back([&, t]() {
+            CsvRow row;
+            size_t offset = bounds[t];
+            while (offset < bounds[t + 1] && file.ReadRow(offset, row)) {
+                if (row.Size() >= 9) {
+                    queue.Push(bidFromRow(row));
+                }
+            }
+            producersDone.fetch_add(1, memory_order_release);
+        });
+    }
+
+    vector<Bid> batch;
+    batch.reserve(INGEST_BATCH);
+    while (true) {
+        // checked before draining, so an empty drain after every producer finished means nothing is left
+        bool finished = producersDone.load(memory_order_acquire) == producerCount;
+
+        batch.clear();
+        queue.PopBatch(batch, INGEST_BATCH);
+        for (Bid& bid : batch) {
+            hashTable->Insert(std::move(bid));
+        }
+
+        if (batch.empty()) {
+            if (finished) {
+                break;
+            }
+            this_thread::yield();
+        }
+    }
+
+    for (thread& producer : producers) {
+        producer.join();
+    }
+}
+
+/**
+ * Read just the bid ids from a CSV file, to use as search keys
+ *
+ * @param csvPath the path to the CSV file to load
+ * @return every bid id in file order
+ */
+vector<string> loadBidIds(string csvPath) {
+    vector<string> bidIds;
+    MappedCsv file(csvPath);
+    file.ForEachRow([&](const CsvRow& row) {
+        if (row.Size() > 1) {
+            bidIds.push_back(row.Text(1));
+        }
+    });
+    return bidIds;
+}
+
+/**
+ * Ask for a range of bid ids, then scan it through the lazy filtered
+ * view and report the number of bids, their total amount and the
+ * time taken. The bids are read in place, nothing is printed per
+ * row, so this runs at the speed of a scan of the bid array.
+ *
+ * @param hashTable the loaded table
+ */
+void rangeQuery(HashTable* hashTable) {
+    string lo, hi;
+    cout << "Lowest bid id: ";
+    cin >> lo;
+    cout << "Highest bid id: ";
+    cin >> hi;
+
+    auto start = chrono::steady_clock::now();
+    size_t count = 0;
+    double total = 0;
+    for (double amount : hashTable->Range(lo, hi) | views::transform(&Bid::amount)) {
+        total += amount;
+        count++;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << count << " bids from " << lo << " to " << hi << " totalling " << total << endl;
+    cout << "time: " << seconds << " seconds" << endl;
+}
+
+/**
+ * Look up every bid id in the file one at a time with Search,
+ * then again in one call to SearchMany, and report both times.
+ *
+ * @param csvPath the path to the CSV file the table was loaded from
+ * @param hashTable the loaded table
+ */
+void benchmarkSearchMany(string csvPath, HashTable* hashTable) {
+    vector<string> bidIds = loadBidIds(csvPath);
+    vector<string_view> keys(bidIds.begin(), bidIds.end());
+    vector<const Bid*> results(keys.size());
+
+    auto start = chrono::steady_clock::now();
+    size_t found = 0;
+    for (const string& bidId : bidIds) {
+        if (hashTable->Search(bidId).amount != -1) {
+            found++;
+        }
+    }
+    double searchSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    hashTable->SearchMany(keys, results);
+    double batchSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << found << " of " << keys.size() << " bids found" << endl;
+    cout << "Search:     " << searchSeconds << " seconds" << endl;
+    cout << "SearchMany: " << batchSeconds << " seconds" << endl;
+}
 
-            // Create a data structure and add to the collection of bids
-            Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][8];
-            bid.amount = strToDouble(file[i][4], '$');
+/**
+ * Measure Search throughput on a ShardedHashTable at 1, 2, 4, 8
+ * and 16 reader threads. A writer thread removes and re-inserts
+ * bids for the whole run, so the readers are always contending
+ * with live updates. Timing is wall clock, clock() would add up
+ * the CPU time of every thread.
+ *
+ * @param csvPath the path to the CSV file to load
+ */
+void benchmarkConcurrentSearch(string csvPath) {
+    ShardedHashTable table;
+    loadBids(csvPath, &table);
 
-            //cout << "Item: " << bid.title << ", Fund: " << bid.fund << ", Amount: " << bid.amount << endl;
+    vector<string> bidIds = loadBidIds(csvPath);
+    if (bidIds.empty()) {
+        cout << "No bids to search." << endl;
+        return;
+    }
+
+    const chrono::milliseconds runTime(1000);
+    for (unsigned int threadCount : { 1, 2, 4, 8, 16 }) {
+        atomic<bool> stop(false);
+        atomic<unsigned long long> lookups(0);
+
+        // churn the first few bids while the readers run
+        thread writer([&]() {
+            size_t churn = min<size_t>(bidIds.size(), 1024);
+            for (size_t i = 0; !stop.load(memory_order_relaxed); i = (i + 1) % churn) {
+                Bid bid = table.Search(bidIds[i]);
+                table.Remove(bidIds[i]);
+                if (bid.amount != -1) {
+                    table.Insert(bid);
+                }
+            }
+        });
+
+        vector<thread> readers;
+        for (unsigned int t = 0; t < threadCount; t++) {
+            readers.emplace_back([&, t]() {
+                // each reader walks the ids with its own xorshift sequence
+                uint64_t state = 0x9E3779B97F4A7C15ull * (t + 1);
+                unsigned long long count = 0;
+                while (!stop.load(memory_order_relaxed)) {
+                    state ^= state << 13;
+                    state ^= state >> 7;
+                    state ^= state << 17;
+                    table.Search(bidIds[state % bidIds.size()]);
+                    count++;
+                }
+                lookups += count;
+            });
+        }
 
-            // push this bid to the end
-            hashTable->Insert(bid);
+        auto start = chrono::steady_clock::now();
+        this_thread::sleep_for(runTime);
+        stop = true;
+        for (thread& reader : readers) {
+            reader.join();
         }
-    } catch (csv::Error &e) {
-        std::cerr << e.what() << std::endl;
+        writer.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << "threads: " << threadCount << " | lookups/sec: " << (unsigned long long)(lookups / seconds) << endl;
     }
 }
 
 /**
- * Simple C function to convert a string to a double
- * after stripping out unwanted char
+ * Measure the BidQueue on its own, with 1, 2, 4 and 8 producers
+ * pushing copies of the file's bids to one consumer, then the
+ * pipelined load into a HashTable with the same producer counts,
+ * against the plain single threaded load.
  *
- * credit: http://stackoverflow.com/a/24875936
+ * @param csvPath the path to the CSV file to load
+ */
+void benchmarkIngestQueue(string csvPath) {
+    HashTable plainTable;
+    auto start = chrono::steady_clock::now();
+    loadBids(csvPath, &plainTable);
+    double plainSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    vector<Bid> bids(plainTable.Bids().begin(), plainTable.Bids().end());
+    if (bids.empty()) {
+        cout << "No bids to queue." << endl;
+        return;
+    }
+
+    // enough messages that the run is not over before every producer has started
+    const size_t messageCount = max<size_t>(bids.size(), 1000000);
+    cout << "plain load: " << plainSeconds << " seconds" << endl;
+
+    for (unsigned int producerCount : { 1, 2, 4, 8 }) {
+        BidQueue queue(INGEST_QUEUE_CAPACITY);
+        vector<thread> producers;
+        start = chrono::steady_clock::now();
+        for (unsigned int t = 0; t < producerCount; t++) {
+            producers.emplace_back([&, t]() {
+                for (size_t i = t; i < messageCount; i += producerCount) {
+                    queue.Push(bids[i % bids.size()]);
+                }
+            });
+        }
+
+        // drain and count, as a stand in for a consumer that does no work
+        vector<Bid> batch;
+        batch.reserve(INGEST_BATCH);
+        size_t received = 0;
+        while (received < messageCount) {
+            batch.clear();
+            size_t taken = queue.PopBatch(batch, INGEST_BATCH);
+            if (taken == 0) {
+                this_thread::yield();
+            }
+            received += taken;
+        }
+        for (thread& producer : producers) {
+            producer.join();
+        }
+        double queueSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        HashTable table;
+        start = chrono::steady_clock::now();
+        loadBidsPipelined(csvPath, &table, producerCount);
+        double loadSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << "producers: " << producerCount
+             << " | queue: " << (unsigned long long)(received / queueSeconds) << " bids/sec"
+             << " | pipelined load: " << loadSeconds << " seconds, " << table.Size() << " bids" << endl;
+    }
+}
+
+/**
+ * Load the bids into a new table with loadBids on 1, 2, 4 and 8
+ * threads, and report rows and bytes read per second for each
  *
- * @param ch The character to strip out
+ * @param csvPath the path to the CSV file to load
  */
-double strToDouble(string str, char ch) {
-    str.erase(remove(str.begin(), str.end(), ch), str.end());
-    return atof(str.c_str());
+void benchmarkLoad(string csvPath) {
+    size_t fileBytes = MappedCsv(csvPath).Size();
+    for (unsigned int threadCount : { 1, 2, 4, 8 }) {
+        HashTable table;
+
+        auto start = chrono::steady_clock::now();
+        loadBids(csvPath, &table, threadCount);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << "threads: " << threadCount << " | rows/sec: " << (unsigned long long)(table.Size() / seconds)
+             << " | GB/s: " << fileBytes / seconds / 1e9 << endl;
+    }
 }
 
 /**
@@ -264,7 +1335,7 @@ int main(int argc, char* argv[]) {
     clock_t ticks;
 
     // Define a hash table to hold all the bids
-    HashTable* bidTable;
+    HashTable* bidTable = new HashTable();
 
     Bid bid;
 
@@ -275,13 +1346,15 @@ int main(int argc, char* argv[]) {
         cout << "  2. Display All Bids" << endl;
         cout << "  3. Find Bid" << endl;
         cout << "  4. Remove Bid" << endl;
+        cout << "  5. Concurrent Search Benchmark" << endl;
+        cout << "  6. Batched Search Benchmark" << endl;
+        cout << "  7. Range Query" << endl;
+        cout << "  8. Ingest Queue Benchmark" << endl;
         cout << "  9. Exit" << endl;
+        cout << "  10. Load Benchmark" << endl;
         cout << "Enter choice: ";
         cin >> choice;
 
-
-		bidTable = new HashTable();
-
         switch (choice) {
 
         case 1:
@@ -290,7 +1363,9 @@ int main(int argc, char* argv[]) {
             ticks = clock();
 
             // Complete the method call to load the bids
-            loadBids(csvPath, bidTable);
+            loadBids(csvPath, bidTable, max(thread::hardware_concurrency(), 1u));
+
+            cout << bidTable->Size() << " bids read" << endl;
 
             // Calculate elapsed time and display result
             ticks = clock() - ticks; // current clock ticks minus starting clock ticks
@@ -309,7 +1384,7 @@ int main(int argc, char* argv[]) {
 
             ticks = clock() - ticks; // current clock ticks minus starting clock ticks
 
-            if (!bid.bidId.empty()) {
+            if (bid.amount != -1) {
                 displayBid(bid);
             } else {
                 cout << "Bid Id " << bidKey << " not found." << endl;
@@ -322,9 +1397,31 @@ int main(int argc, char* argv[]) {
         case 4:
             bidTable->Remove(bidKey);
             break;
+
+        case 5:
+            benchmarkConcurrentSearch(csvPath);
+            break;
+
+        case 6:
+            benchmarkSearchMany(csvPath, bidTable);
+            break;
+
+        case 7:
+            rangeQuery(bidTable);
+            break;
+
+        case 8:
+            benchmarkIngestQueue(csvPath);
+            break;
+
+        case 10:
+            benchmarkLoad(csvPath);
+            break;
         }
     }
 
+    delete bidTable;
+
     cout << "Good bye." << endl;
 
     return 0;
@@ -8,10 +8,22 @@
 //============================================================================
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string_view>
+#include <thread>
 #include <time.h>
+#include <vector>
 
-#include "CSVparser.hpp"
+#include "MappedCsv.hpp"
 
 using namespace std;
 
@@ -19,6 +31,15 @@ using namespace std;
 // Global definitions visible to all methods and classes
 //============================================================================
 
+//Number of nodes a NodeArena allocates at a time.
+const size_t NODE_CHUNK_SIZE = 256;
+
+//Number of bids in each chunk of an UnrolledLinkedList.
+const size_t UNROLLED_CHUNK_BIDS = 32;
+
+//Most lanes a skip list node can be in. With each lane a quarter of the one below, 16 covers billions of bids.
+const int SKIP_LIST_MAX_LEVEL = 16;
+
 // forward declarations
 double strToDouble(string str, char ch);
 
@@ -37,19 +58,112 @@ struct Bid {
 // Linked-List class definition
 //============================================================================
 
+//Internal structure for a list node.
+struct ListNode {
+
+	//Data that represents whatever is being stored in this linked list.
+	Bid bid;
+
+	//Pointer to the next node in the linked list, nullptr at the tail.
+	ListNode* next;
+};
+
+/**
+ * Define a class containing data members and methods to
+ * implement a pool allocator owning every node of one list.
+ *
+ * Nodes are handed out from contiguous chunks rather than one heap
+ * allocation each, so walking a list built by appending reads
+ * mostly sequential memory. Removed nodes go on a free list
+ * (threaded through next) and are reused first, and the whole
+ * pool is freed a chunk at a time.
+ */
+class NodeArena {
+
+private:
+
+	//Every chunk of nodes allocated, the last one being the one currently handed out from.
+	vector< unique_ptr< ListNode[] > > chunks;
+
+	//How many nodes of the last chunk have been handed out.
+	size_t chunk_used;
+
+	//Nodes given back by Free, waiting to be reused.
+	ListNode* free_list;
+
+public:
+	NodeArena();
+	ListNode* Allocate();							//A node with no next node.
+	void Free(ListNode* node);						//Give a node back for reuse.
+	void Release();									//Free every node at once.
+};
+
+/**
+ * Default constructor, an empty pool
+ */
+NodeArena::NodeArena() : chunk_used(NODE_CHUNK_SIZE), free_list(nullptr) {
+}
+
+/**
+ * A node from the free list if there is one, otherwise the next unused node of the current chunk
+ */
+ListNode* NodeArena::Allocate() {
+	ListNode* node;
+	if (free_list != nullptr) {
+		node = free_list;
+		free_list = node->next;
+	}
+	else {
+		if (chunk_used == NODE_CHUNK_SIZE) {
+			chunks.emplace_back(new ListNode[NODE_CHUNK_SIZE]);
+			chunk_used = 0;
+		}
+		node = &chunks.back()[chunk_used++];
+	}
+	node->next = nullptr;
+	return node;
+}
+
+/**
+ * Give a node back. Its bid is cleared now so the strings are not
+ * held on to until the node is reused.
+ */
+void NodeArena::Free(ListNode* node) {
+	node->bid = Bid();
+	node->next = free_list;
+	free_list = node;
+}
+
+/**
+ * Free every node, one delete[] per chunk rather than one delete per node
+ */
+void NodeArena::Release() {
+	chunks.clear();
+	chunk_used = NODE_CHUNK_SIZE;
+	free_list = nullptr;
+}
+
 /**
  * Define a class containing data members and methods to
  * implement a linked-list.
+ *
+ * The list keeps both ends and its length, so Append and Prepend
+ * are O(1) and Size never walks the list. Every operation loops
+ * rather than recursing, so a long list cannot overflow the stack.
  */
 class LinkedList {
 
 private:
 
-    //Pointer to the next node in the linked list.
-	LinkedList* m_next_node;
-	
-	//Data that represents whatever is being stored in this linked list.
-	Bid m_bid;
+	//First and last nodes in the list, both nullptr while it is empty.
+	ListNode* m_head;
+	ListNode* m_tail;
+
+	//Number of bids in the list.
+	int m_size;
+
+	//Owns every node in the list.
+	NodeArena m_arena;
 
 public:
     LinkedList();
@@ -60,18 +174,22 @@ public:
     void Remove(string bidId);
     Bid Search(string bidId);
     int Size();
+    template <typename Visitor>
+    void ForEach(Visitor visit);
 };
 
 /**
  * Default constructor
  */
-LinkedList::LinkedList() : m_next_node(nullptr), m_bid(NULL) {
+LinkedList::LinkedList() : m_head(nullptr), m_tail(nullptr), m_size(0) {
 }
 
 /**
  * Destructor
  */
 LinkedList::~LinkedList() {
+	//The arena owns every node, so releasing it frees the whole list without walking it.
+	m_arena.Release();
 }
 
 /**
@@ -79,16 +197,18 @@ LinkedList::~LinkedList() {
  */
 void LinkedList::Append(Bid bid) {
 
-	//Check if there is another node after this one. If so, recursively call Append on the next node.
-	if (m_next_node != nullptr)
-		m_next_node->Append(bid);
+	//Create a node holding the bid.
+	ListNode* node = m_arena.Allocate();
+	node->bid = std::move(bid);
 
-	//If there is no other node after this one, create one, set the data, and set the pointer to the next node.
-	else {
-		m_next_node = new LinkedList();
-		m_next_node->m_bid = bid;
-		size++;
-	}
+	//Link it after the current tail, or make it the head as well if the list is empty.
+	if (m_tail != nullptr)
+		m_tail->next = node;
+	else
+		m_head = node;
+	m_tail = node;
+
+	m_size++;
 }
 
 /**
@@ -97,16 +217,16 @@ void LinkedList::Append(Bid bid) {
 void LinkedList::Prepend(Bid bid) {
 
 	//Create a new node and set the bid as the data.
-	LinkedList* newNode = new LinkedList();
-	
+	ListNode* node = m_arena.Allocate();
+	node->bid = std::move(bid);
+
 	//Set this new node to point it's next node to the beginning of the list.
-	newNode->m_bid = m_bid;
-	newNode->m_next_node = m_next_node;
-	
-	m_bid = bid;
-	m_next_node = newNode;
+	node->next = m_head;
+	m_head = node;
+	if (m_tail == nullptr)
+		m_tail = node;
 
-	size++;
+	m_size++;
 }
 
 /**
@@ -114,10 +234,11 @@ void LinkedList::Prepend(Bid bid) {
  */
 void LinkedList::PrintList() {
 
-	//Print this nodes data, and if there's a next node in the list, call this function recursively on it.
-	cout << m_bid.bidId << ", " << m_bid.title << ", " << m_bid.title << ", " << m_bid.amount << endl;
-	if (m_next_node != nullptr)
-		m_next_node->PrintList();
+	//Print each node's data in turn. The output is flushed once at the end rather than after every row.
+	for (ListNode* node = m_head; node != nullptr; node = node->next) {
+		cout << node->bid.bidId << ", " << node->bid.title << ", " << node->bid.fund << ", " << node->bid.amount << '\n';
+	}
+	cout.flush();
 }
 
 /**
@@ -126,24 +247,326 @@ void LinkedList::PrintList() {
  * @param bidId The bid id to remove from the list
  */
 void LinkedList::Remove(string bidId) {
-	
-	//Check if bid belongs to the root node.
-	if (m_bid.bidId == bidId) {
-		size--
+
+	//Walk the list, keeping the node before the current one so the match can be unlinked in place.
+	ListNode* previous = nullptr;
+	ListNode* node = m_head;
+	while (node != nullptr && node->bid.bidId != bidId) {
+		previous = node;
+		node = node->next;
+	}
+
+	//Not in the list.
+	if (node == nullptr)
+		return;
+
+	//Point the previous node (or the head) past the match, and move the tail back if the match was the last node.
+	if (previous != nullptr)
+		previous->next = node->next;
+	else
+		m_head = node->next;
+	if (m_tail == node)
+		m_tail = previous;
+
+	m_arena.Free(node);
+	m_size--;
+}
+
+/**
+ * Search for the specified bidId
+ *
+ * @param bidId The bid id to search for
+ */
+Bid LinkedList::Search(string bidId) {
+
+	//Check each node in turn for the matching data.
+	for (ListNode* node = m_head; node != nullptr; node = node->next) {
+		if (node->bid.bidId == bidId)
+			return node->bid;
 	}
 
-	//Otherwise, check the next node. If it's the correct node, delete it and set this nodes next node to that nodes child node, if there is one.
-	else if (m_next_node != nullptr) {
-		if (m_next_node->m_bid.bidId == bidId) {
-			LinkedList* tempNextNode = m_next_node->m_next_node;
-			delete m_next_node;
-			m_next_node = tempNextNode;
-			size--;
+	//Lastly, if none of the nodes matched, return an empty bid to represent no match found.
+	Bid emptyBid;
+	emptyBid.amount = -1;
+	return emptyBid;
+}
+
+/**
+ * Returns the current size (number of elements) in the list
+ */
+int LinkedList::Size() {
+    return m_size;
+}
+
+/**
+ * Call visit(const Bid&) for every bid, in list order
+ */
+template <typename Visitor>
+void LinkedList::ForEach(Visitor visit) {
+	for (ListNode* node = m_head; node != nullptr; node = node->next) {
+		visit(node->bid);
+	}
+}
+
+//============================================================================
+// Unrolled Linked-List class definition
+//============================================================================
+
+/**
+ * The first 8 bytes of a key as one integer, packed big endian and
+ * zero padded, so comparing two prefixes as integers gives the same
+ * order as comparing the strings. Bid ids are short, so a prefix
+ * mismatch rules a bid out without touching its string.
+ *
+ * @param key The key to pack
+ * @return The packed prefix
+ */
+static inline uint64_t keyPrefix(std::string_view key) {
+	uint64_t prefix = 0;
+	for (size_t i = 0; i < 8; i++) {
+		prefix = (prefix << 8) | (i < key.size() ? (uint8_t)key[i] : 0);
+	}
+	return prefix;
+}
+
+//Internal structure for an unrolled list chunk. Holds up to UNROLLED_CHUNK_BIDS bids, in list order, in its first count entries.
+struct BidChunk {
+
+	//Next chunk in the list, nullptr at the tail.
+	BidChunk* next;
+
+	//Number of entries in use.
+	size_t count;
+
+	//Key prefix of each bid, so a search scans one small contiguous array and only looks at a Bid on a prefix match.
+	uint64_t key_prefixes[UNROLLED_CHUNK_BIDS];
+
+	Bid bids[UNROLLED_CHUNK_BIDS];
+};
+
+/**
+ * Define a class containing data members and methods to
+ * implement an unrolled linked-list.
+ *
+ * Each node is a chunk of up to UNROLLED_CHUNK_BIDS bids stored
+ * side by side, so a scan follows one pointer per chunk rather
+ * than one per bid and reads the bids in between sequentially,
+ * the way a vector would. Inserting or removing at a position
+ * only shifts the bids of one chunk. A remove that leaves a chunk
+ * under half full merges it with a neighbour when the two fit in
+ * one, or else moves one bid over from that neighbour, so every
+ * chunk but the first and the last stays at least half full. Those
+ * two can be sparser: Prepend and Append fill them a bid at a time.
+ */
+class UnrolledLinkedList {
+
+private:
+
+	//First and last chunks in the list, both nullptr while it is empty.
+	BidChunk* m_head;
+	BidChunk* m_tail;
+
+	//Number of bids in the list.
+	int m_size;
+
+	//Private helper functions used to manage the chunks.
+	BidChunk* newChunk();
+	void mergeNext(BidChunk* chunk);
+	void rebalance(BidChunk* previous, BidChunk* chunk);
+
+public:
+    UnrolledLinkedList();
+    virtual ~UnrolledLinkedList();
+    void Append(Bid bid);
+    void Prepend(Bid bid);
+    void PrintList();
+    void Remove(string bidId);
+    Bid Search(string bidId);
+    int Size();
+    template <typename Visitor>
+    void ForEach(Visitor visit);
+};
+
+/**
+ * Default constructor
+ */
+UnrolledLinkedList::UnrolledLinkedList() : m_head(nullptr), m_tail(nullptr), m_size(0) {
+}
+
+/**
+ * Destructor
+ */
+UnrolledLinkedList::~UnrolledLinkedList() {
+	while (m_head != nullptr) {
+		BidChunk* next = m_head->next;
+		delete m_head;
+		m_head = next;
+	}
+}
+
+/**
+ * An empty chunk, not yet linked into the list
+ */
+BidChunk* UnrolledLinkedList::newChunk() {
+	BidChunk* chunk = new BidChunk();
+	chunk->next = nullptr;
+	chunk->count = 0;
+	return chunk;
+}
+
+/**
+ * Move the bids of the chunk after this one into it and unlink that
+ * chunk, if they all fit
+ */
+void UnrolledLinkedList::mergeNext(BidChunk* chunk) {
+	BidChunk* next = chunk->next;
+	if (next == nullptr || chunk->count + next->count > UNROLLED_CHUNK_BIDS)
+		return;
+
+	for (size_t i = 0; i < next->count; i++) {
+		chunk->key_prefixes[chunk->count] = next->key_prefixes[i];
+		chunk->bids[chunk->count++] = std::move(next->bids[i]);
+	}
+	chunk->next = next->next;
+	if (m_tail == next)
+		m_tail = chunk;
+	delete next;
+}
+
+/**
+ * Top up a chunk that a remove left under half full, from the chunk
+ * before it if there is one, otherwise from the chunk after it.
+ * Merges the two when they fit in one chunk, and otherwise moves
+ * over the one bid next to the chunk, which the neighbour can spare
+ * since the two together overfill a chunk.
+ *
+ * @param previous The chunk before this one, nullptr for the head
+ * @param chunk The chunk a bid was removed from
+ */
+void UnrolledLinkedList::rebalance(BidChunk* previous, BidChunk* chunk) {
+	if (chunk->count >= UNROLLED_CHUNK_BIDS / 2)
+		return;
+
+	if (previous != nullptr) {
+		if (previous->count + chunk->count <= UNROLLED_CHUNK_BIDS) {
+			mergeNext(previous);
+			return;
 		}
-		
-		//Lastly, if neither of the above were the matching node, call the Remove function recursively on the next node.
+
+		//Borrow the previous chunk's last bid, at the front of this one.
+		std::move_backward(chunk->key_prefixes, chunk->key_prefixes + chunk->count, chunk->key_prefixes + chunk->count + 1);
+		std::move_backward(chunk->bids, chunk->bids + chunk->count, chunk->bids + chunk->count + 1);
+		previous->count--;
+		chunk->key_prefixes[0] = previous->key_prefixes[previous->count];
+		chunk->bids[0] = std::move(previous->bids[previous->count]);
+		previous->bids[previous->count] = Bid();
+		chunk->count++;
+		return;
+	}
+
+	BidChunk* next = chunk->next;
+	if (next == nullptr) {
+
+		//The only chunk. Unlink it once it is empty.
+		if (chunk->count == 0) {
+			delete chunk;
+			m_head = nullptr;
+			m_tail = nullptr;
+		}
+		return;
+	}
+	if (chunk->count + next->count <= UNROLLED_CHUNK_BIDS) {
+		mergeNext(chunk);
+		return;
+	}
+
+	//Borrow the next chunk's first bid, at the end of this one.
+	chunk->key_prefixes[chunk->count] = next->key_prefixes[0];
+	chunk->bids[chunk->count++] = std::move(next->bids[0]);
+	std::move(next->key_prefixes + 1, next->key_prefixes + next->count, next->key_prefixes);
+	std::move(next->bids + 1, next->bids + next->count, next->bids);
+	next->count--;
+	next->bids[next->count] = Bid();
+}
+
+/**
+ * Append a new bid to the end of the list
+ */
+void UnrolledLinkedList::Append(Bid bid) {
+
+	//Start a new chunk when the last one is full, or the list is empty.
+	if (m_tail == nullptr || m_tail->count == UNROLLED_CHUNK_BIDS) {
+		BidChunk* chunk = newChunk();
+		if (m_tail != nullptr)
+			m_tail->next = chunk;
 		else
-			m_next_node->Remove(bidId);
+			m_head = chunk;
+		m_tail = chunk;
+	}
+
+	m_tail->key_prefixes[m_tail->count] = keyPrefix(bid.bidId);
+	m_tail->bids[m_tail->count++] = std::move(bid);
+	m_size++;
+}
+
+/**
+ * Prepend a new bid to the start of the list
+ */
+void UnrolledLinkedList::Prepend(Bid bid) {
+
+	//Start a new chunk when the first one is full, or the list is empty.
+	if (m_head == nullptr || m_head->count == UNROLLED_CHUNK_BIDS) {
+		BidChunk* chunk = newChunk();
+		chunk->next = m_head;
+		m_head = chunk;
+		if (m_tail == nullptr)
+			m_tail = chunk;
+	}
+
+	//Shift the chunk's bids up one to make room at the front.
+	std::move_backward(m_head->key_prefixes, m_head->key_prefixes + m_head->count, m_head->key_prefixes + m_head->count + 1);
+	std::move_backward(m_head->bids, m_head->bids + m_head->count, m_head->bids + m_head->count + 1);
+	m_head->key_prefixes[0] = keyPrefix(bid.bidId);
+	m_head->bids[0] = std::move(bid);
+	m_head->count++;
+	m_size++;
+}
+
+/**
+ * Simple output of all bids in the list
+ */
+void UnrolledLinkedList::PrintList() {
+	ForEach([](const Bid& bid) {
+		cout << bid.bidId << ", " << bid.title << ", " << bid.fund << ", " << bid.amount << '\n';
+	});
+	cout.flush();
+}
+
+/**
+ * Remove a specified bid
+ *
+ * @param bidId The bid id to remove from the list
+ */
+void UnrolledLinkedList::Remove(string bidId) {
+	uint64_t prefix = keyPrefix(bidId);
+
+	//Walk the chunks, keeping the one before the current one so a chunk left short can be merged into it.
+	BidChunk* previous = nullptr;
+	for (BidChunk* chunk = m_head; chunk != nullptr; previous = chunk, chunk = chunk->next) {
+		for (size_t i = 0; i < chunk->count; i++) {
+			if (chunk->key_prefixes[i] != prefix || chunk->bids[i].bidId != bidId)
+				continue;
+
+			//Close the gap in this chunk.
+			std::move(chunk->key_prefixes + i + 1, chunk->key_prefixes + chunk->count, chunk->key_prefixes + i);
+			std::move(chunk->bids + i + 1, chunk->bids + chunk->count, chunk->bids + i);
+			chunk->count--;
+			chunk->bids[chunk->count] = Bid();
+			m_size--;
+
+			rebalance(previous, chunk);
+			return;
+		}
 	}
 }
 
@@ -152,29 +575,459 @@ void LinkedList::Remove(string bidId) {
  *
  * @param bidId The bid id to search for
  */
-Bid LinkedList::Search(string bidId) {
+Bid UnrolledLinkedList::Search(string bidId) {
+	uint64_t prefix = keyPrefix(bidId);
+
+	for (BidChunk* chunk = m_head; chunk != nullptr; chunk = chunk->next) {
+		for (size_t i = 0; i < chunk->count; i++) {
+			if (chunk->key_prefixes[i] == prefix && chunk->bids[i].bidId == bidId)
+				return chunk->bids[i];
+		}
+	}
 
-	//Check if the root node is the matching data.
-	if (m_bid.bidId == bidId)
-		return m_bid;
+	//No match found, the same empty bid LinkedList returns.
+	Bid emptyBid;
+	emptyBid.amount = -1;
+	return emptyBid;
+}
 
-	//Otherwise, check the child node, if there is one.
-	else if (m_next_node != nullptr)
-		m_next_node->Search(bidId);
+/**
+ * Returns the current size (number of elements) in the list
+ */
+int UnrolledLinkedList::Size() {
+    return m_size;
+}
 
-	//Lastly, if not the root or any of the children after recursive calling, return an empty bid to represent no match found.
-	else {
-		Bid emptyBid;
-		emptyBid.amount = -1;
-		return emptyBid;
+/**
+ * Call visit(const Bid&) for every bid, in list order
+ */
+template <typename Visitor>
+void UnrolledLinkedList::ForEach(Visitor visit) {
+	for (BidChunk* chunk = m_head; chunk != nullptr; chunk = chunk->next) {
+		for (size_t i = 0; i < chunk->count; i++) {
+			visit(chunk->bids[i]);
+		}
+	}
+}
+
+//============================================================================
+// Skip List class definition
+//============================================================================
+
+/**
+ * Height for a new skip list node, counting from 1. Each extra
+ * level is taken with probability 1/4, from pairs of random bits,
+ * so about one node in four appears in each lane above the last.
+ */
+static int randomSkipLevel(mt19937& random) {
+	int level = 1 + std::countr_zero((uint32_t)random()) / 2;
+	return std::min(level, SKIP_LIST_MAX_LEVEL);
+}
+
+//Internal structure for a skip list node. The node is allocated with room for its level links right after it.
+struct SkipNode {
+	Bid bid;
+	int level;
+
+	//Next node in each lane this node is in, from level 0 (every node) up.
+	SkipNode** next;
+};
+
+/**
+ * Define a class containing data members and methods to
+ * implement a skip list of bids ordered by id.
+ *
+ * Level 0 is an ordinary sorted linked list. Each node also joins
+ * a random number of "express lanes" above it, each lane holding
+ * about a quarter of the nodes of the one below, so a search runs
+ * along the top lane and drops down a lane whenever the next step
+ * would overshoot. Search, Insert and Remove take expected
+ * O(log n), and ordered iteration is just a walk of level 0.
+ */
+class SkipList {
+
+private:
+
+	//Sentinel before the first node, in every lane.
+	SkipNode* m_head;
+
+	//Number of lanes currently in use.
+	int m_level;
+
+	//Number of bids in the list.
+	int m_size;
+
+	mt19937 m_random;
+
+	//Private helper functions used to allocate nodes and to find a key.
+	static SkipNode* newNode(int level);
+	static void deleteNode(SkipNode* node);
+	SkipNode* findPredecessors(std::string_view bidId, SkipNode** predecessors);
+
+public:
+    SkipList();
+    virtual ~SkipList();
+    void Insert(Bid bid);
+    void PrintList();
+    void Remove(string bidId);
+    Bid Search(string bidId);
+    int Size();
+    template <typename Visitor>
+    void ForEach(Visitor visit);
+};
+
+/**
+ * Default constructor
+ */
+SkipList::SkipList() : m_level(1), m_size(0), m_random(179) {
+	m_head = newNode(SKIP_LIST_MAX_LEVEL);
+}
+
+/**
+ * Destructor
+ */
+SkipList::~SkipList() {
+	while (m_head != nullptr) {
+		SkipNode* next = m_head->next[0];
+		deleteNode(m_head);
+		m_head = next;
 	}
 }
 
+/**
+ * A node with empty links, in one allocation with its array of level links
+ */
+SkipNode* SkipList::newNode(int level) {
+	void* memory = ::operator new(sizeof(SkipNode) + level * sizeof(SkipNode*));
+	SkipNode* node = new (memory) SkipNode();
+	node->level = level;
+	node->next = reinterpret_cast<SkipNode**>(node + 1);
+	std::fill(node->next, node->next + level, nullptr);
+	return node;
+}
+
+void SkipList::deleteNode(SkipNode* node) {
+	node->~SkipNode();
+	::operator delete(node);
+}
+
+/**
+ * Walk down the lanes to the last node before bidId in each one
+ *
+ * @param predecessors Filled with that node for every lane in use
+ * @return The first node at or after bidId, nullptr if there is none
+ */
+SkipNode* SkipList::findPredecessors(std::string_view bidId, SkipNode** predecessors) {
+	SkipNode* node = m_head;
+	for (int level = m_level - 1; level >= 0; level--) {
+		while (node->next[level] != nullptr && node->next[level]->bid.bidId < bidId)
+			node = node->next[level];
+		predecessors[level] = node;
+	}
+	return node->next[0];
+}
+
+/**
+ * Insert a bid in id order, after any bids with the same id
+ */
+void SkipList::Insert(Bid bid) {
+	SkipNode* predecessors[SKIP_LIST_MAX_LEVEL];
+	SkipNode* node = m_head;
+	for (int level = m_level - 1; level >= 0; level--) {
+		while (node->next[level] != nullptr && node->next[level]->bid.bidId <= bid.bidId)
+			node = node->next[level];
+		predecessors[level] = node;
+	}
+
+	//Lanes the list did not use yet start from the head.
+	int level = randomSkipLevel(m_random);
+	for (; m_level < level; m_level++)
+		predecessors[m_level] = m_head;
+
+	SkipNode* inserted = newNode(level);
+	inserted->bid = std::move(bid);
+	for (int i = 0; i < level; i++) {
+		inserted->next[i] = predecessors[i]->next[i];
+		predecessors[i]->next[i] = inserted;
+	}
+	m_size++;
+}
+
+/**
+ * Simple output of all bids in the list, in id order
+ */
+void SkipList::PrintList() {
+	ForEach([](const Bid& bid) {
+		cout << bid.bidId << ", " << bid.title << ", " << bid.fund << ", " << bid.amount << '\n';
+	});
+	cout.flush();
+}
+
+/**
+ * Remove a specified bid
+ *
+ * @param bidId The bid id to remove from the list
+ */
+void SkipList::Remove(string bidId) {
+	SkipNode* predecessors[SKIP_LIST_MAX_LEVEL];
+	SkipNode* node = findPredecessors(bidId, predecessors);
+	if (node == nullptr || node->bid.bidId != bidId)
+		return;
+
+	//Unlink it from every lane it is in, then drop lanes left empty.
+	for (int level = 0; level < node->level; level++)
+		predecessors[level]->next[level] = node->next[level];
+	while (m_level > 1 && m_head->next[m_level - 1] == nullptr)
+		m_level--;
+
+	deleteNode(node);
+	m_size--;
+}
+
+/**
+ * Search for the specified bidId
+ *
+ * @param bidId The bid id to search for
+ */
+Bid SkipList::Search(string bidId) {
+	SkipNode* node = m_head;
+	for (int level = m_level - 1; level >= 0; level--) {
+		while (node->next[level] != nullptr && node->next[level]->bid.bidId < bidId)
+			node = node->next[level];
+	}
+	node = node->next[0];
+	if (node != nullptr && node->bid.bidId == bidId)
+		return node->bid;
+
+	//No match found, the same empty bid LinkedList returns.
+	Bid emptyBid;
+	emptyBid.amount = -1;
+	return emptyBid;
+}
+
 /**
  * Returns the current size (number of elements) in the list
  */
-int LinkedList::Size() {
-    return size;
+int SkipList::Size() {
+    return m_size;
+}
+
+/**
+ * Call visit(const Bid&) for every bid, in id order
+ */
+template <typename Visitor>
+void SkipList::ForEach(Visitor visit) {
+	for (SkipNode* node = m_head->next[0]; node != nullptr; node = node->next[0]) {
+		visit(node->bid);
+	}
+}
+
+//============================================================================
+// Concurrent Skip List class definition
+//============================================================================
+
+//Internal structure for a concurrent skip list node. The bid never changes once the node is linked in.
+struct ConcurrentSkipNode {
+	Bid bid;
+	int level;
+
+	//Set once the bid is removed. The node stays linked, and is skipped by searches.
+	std::atomic< bool > removed;
+
+	//Next node in each lane this node is in, from level 0 up, allocated right after the node.
+	std::atomic< ConcurrentSkipNode* >* next;
+};
+
+/**
+ * Define a class containing data members and methods to
+ * implement a lock-free skip list of bids ordered by id.
+ *
+ * Any number of threads may Insert, Remove and Search at once with
+ * no locks. A new node is fully built, then published by one
+ * compare-and-swap into level 0, which is the moment it becomes
+ * part of the list. It is then linked into its express lanes one
+ * at a time, which only speeds up later searches, so a search that
+ * misses the upper links still finds it along level 0. A failed
+ * compare-and-swap means another thread changed that link first,
+ * and the insert finds its place again and retries.
+ *
+ * Remove only marks the node removed. Unlinking and freeing nodes
+ * while other threads may be standing on them would need epoch or
+ * hazard pointer reclamation, so removed nodes are freed with the
+ * list instead, and a bid id that is removed can be inserted again
+ * as a new node.
+ */
+class ConcurrentSkipList {
+
+private:
+
+	//Sentinel before the first node, in every lane.
+	ConcurrentSkipNode* m_head;
+
+	//Number of bids in the list, not counting removed ones.
+	std::atomic< int > m_size;
+
+	//Private helper functions used to allocate nodes and to find a key.
+	static ConcurrentSkipNode* newNode(int level);
+	static void deleteNode(ConcurrentSkipNode* node);
+	ConcurrentSkipNode* find(std::string_view bidId, ConcurrentSkipNode** predecessors, ConcurrentSkipNode** successors);
+
+public:
+    ConcurrentSkipList();
+    virtual ~ConcurrentSkipList();
+    bool Insert(Bid bid);							//False, and nothing inserted, when the id is already in the list.
+    void Remove(string bidId);
+    Bid Search(string bidId);
+    int Size();
+};
+
+/**
+ * Default constructor
+ */
+ConcurrentSkipList::ConcurrentSkipList() : m_size(0) {
+	m_head = newNode(SKIP_LIST_MAX_LEVEL);
+}
+
+/**
+ * Destructor. No other thread may be using the list.
+ */
+ConcurrentSkipList::~ConcurrentSkipList() {
+	while (m_head != nullptr) {
+		ConcurrentSkipNode* next = m_head->next[0].load(memory_order_relaxed);
+		deleteNode(m_head);
+		m_head = next;
+	}
+}
+
+/**
+ * A node with empty links, in one allocation with its array of level links
+ */
+ConcurrentSkipNode* ConcurrentSkipList::newNode(int level) {
+	typedef std::atomic< ConcurrentSkipNode* > Link;
+	void* memory = ::operator new(sizeof(ConcurrentSkipNode) + level * sizeof(Link));
+	ConcurrentSkipNode* node = new (memory) ConcurrentSkipNode();
+	node->level = level;
+	node->removed.store(false, memory_order_relaxed);
+	node->next = reinterpret_cast<Link*>(node + 1);
+	for (int i = 0; i < level; i++)
+		new (&node->next[i]) Link(nullptr);
+	return node;
+}
+
+void ConcurrentSkipList::deleteNode(ConcurrentSkipNode* node) {
+	node->~ConcurrentSkipNode();
+	::operator delete(node);
+}
+
+/**
+ * Walk down the lanes to the last node before bidId in each one
+ *
+ * @param predecessors Filled with that node for every lane
+ * @param successors Filled with the node after it, the first at or after bidId
+ * @return The first live node with exactly bidId, nullptr if there is none
+ */
+ConcurrentSkipNode* ConcurrentSkipList::find(std::string_view bidId, ConcurrentSkipNode** predecessors, ConcurrentSkipNode** successors) {
+	ConcurrentSkipNode* node = m_head;
+	for (int level = SKIP_LIST_MAX_LEVEL - 1; level >= 0; level--) {
+		ConcurrentSkipNode* next = node->next[level].load(memory_order_acquire);
+		while (next != nullptr && next->bid.bidId < bidId) {
+			node = next;
+			next = node->next[level].load(memory_order_acquire);
+		}
+		predecessors[level] = node;
+		successors[level] = next;
+	}
+
+	//Bids with the same id sit together, live ones first, since each is inserted ahead of any it finds.
+	for (ConcurrentSkipNode* match = successors[0]; match != nullptr && match->bid.bidId == bidId; match = match->next[0].load(memory_order_acquire)) {
+		if (!match->removed.load(memory_order_acquire))
+			return match;
+	}
+	return nullptr;
+}
+
+/**
+ * Insert a bid in id order, unless a bid with the same id is already in the list
+ *
+ * @return Whether the bid was inserted
+ */
+bool ConcurrentSkipList::Insert(Bid bid) {
+	thread_local mt19937 random(std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+	ConcurrentSkipNode* predecessors[SKIP_LIST_MAX_LEVEL];
+	ConcurrentSkipNode* successors[SKIP_LIST_MAX_LEVEL];
+	int level = randomSkipLevel(random);
+	ConcurrentSkipNode* node = newNode(level);
+	node->bid = std::move(bid);
+	const string& bidId = node->bid.bidId;
+
+	//Publish the node at level 0, retrying from a fresh search whenever another thread changes the link first.
+	while (true) {
+		if (find(bidId, predecessors, successors) != nullptr) {
+			deleteNode(node);
+			return false;
+		}
+		for (int i = 0; i < level; i++)
+			node->next[i].store(successors[i], memory_order_relaxed);
+
+		ConcurrentSkipNode* expected = successors[0];
+		if (predecessors[0]->next[0].compare_exchange_strong(expected, node, memory_order_release, memory_order_relaxed))
+			break;
+	}
+	m_size.fetch_add(1, memory_order_relaxed);
+
+	//Then link it into each express lane above, finding the lane's neighbours again if it changed.
+	for (int i = 1; i < level; i++) {
+		while (true) {
+			ConcurrentSkipNode* expected = successors[i];
+			if (predecessors[i]->next[i].compare_exchange_strong(expected, node, memory_order_release, memory_order_relaxed))
+				break;
+			find(bidId, predecessors, successors);
+			node->next[i].store(successors[i], memory_order_relaxed);
+		}
+	}
+	return true;
+}
+
+/**
+ * Remove a specified bid, by marking its node removed
+ *
+ * @param bidId The bid id to remove from the list
+ */
+void ConcurrentSkipList::Remove(string bidId) {
+	ConcurrentSkipNode* predecessors[SKIP_LIST_MAX_LEVEL];
+	ConcurrentSkipNode* successors[SKIP_LIST_MAX_LEVEL];
+	ConcurrentSkipNode* node = find(bidId, predecessors, successors);
+
+	//Only the thread that flips the flag counts the removal.
+	bool expected = false;
+	if (node != nullptr && node->removed.compare_exchange_strong(expected, true, memory_order_acq_rel))
+		m_size.fetch_sub(1, memory_order_relaxed);
+}
+
+/**
+ * Search for the specified bidId
+ *
+ * @param bidId The bid id to search for
+ */
+Bid ConcurrentSkipList::Search(string bidId) {
+	ConcurrentSkipNode* predecessors[SKIP_LIST_MAX_LEVEL];
+	ConcurrentSkipNode* successors[SKIP_LIST_MAX_LEVEL];
+	ConcurrentSkipNode* node = find(bidId, predecessors, successors);
+	if (node != nullptr)
+		return node->bid;
+
+	//No match found, the same empty bid LinkedList returns.
+	Bid emptyBid;
+	emptyBid.amount = -1;
+	return emptyBid;
+}
+
+/**
+ * Returns the current size (number of elements) in the list
+ */
+int ConcurrentSkipList::Size() {
+    return m_size.load(memory_order_relaxed);
 }
 
 //============================================================================
@@ -220,34 +1073,256 @@ Bid getBid() {
 }
 
 /**
- * Load a CSV file containing bids into a LinkedList
+ * Make a bid from a row of the CSV file. Only the four columns a
+ * bid keeps are copied out of the mapping.
+ */
+Bid bidFromRow(const CsvRow& row) {
+    Bid bid;
+    bid.bidId = row.Text(1);
+    bid.title = row.Text(0);
+    bid.fund = row.Text(8);
+    bid.amount = row.Number(4, '$');
+    return bid;
+}
+
+/**
+ * Add the bid in a row of the CSV file to a batch, skipping a row
+ * too short to hold one
+ */
+void appendBidRow(const CsvRow& row, vector<Bid>& batch) {
+    if (row.Size() >= 9) {
+        batch.push_back(bidFromRow(row));
+    }
+}
+
+/**
+ * Load a CSV file containing bids into a list. The file is split
+ * into a chunk of rows per thread, and each thread converts its
+ * chunk into a batch of bids. The batches are then appended in
+ * file order, so the list comes out the same on any thread count.
  *
- * @return a LinkedList containing all the bids read
+ * @param csvPath the path to the CSV file to load
+ * @param list the LinkedList or UnrolledLinkedList to append to
+ * @param threadCount number of threads to convert rows on, including the caller
  */
-void loadBids(string csvPath, LinkedList *list) {
+template <typename List>
+void loadBids(string csvPath, List *list, unsigned int threadCount = 1) {
     cout << "Loading CSV file " << csvPath << endl;
 
-    // initialize the CSV Parser
-    csv::Parser file = csv::Parser(csvPath);
+    // map the file rather than parse it into strings up front
+    MappedCsv file(csvPath);
+    if (!file.IsOpen()) {
+        std::cerr << "Unable to open " << csvPath << std::endl;
+        return;
+    }
 
-    try {
-        // loop to read rows of a CSV file
-        for (int i = 0; i < file.rowCount(); i++) {
+    for (vector<Bid>& batch : file.ReadBatches<Bid>(threadCount, appendBidRow)) {
+        for (Bid& bid : batch) {
+            // add this bid to the end
+            list->Append(std::move(bid));
+        }
+    }
+}
 
-            // initialize a bid using data from current row (i)
-            Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][8];
-            bid.amount = strToDouble(file[i][4], '$');
+/**
+ * Read a CSV file containing bids into a vector, in file order
+ *
+ * @param csvPath the path to the CSV file to load
+ * @return a vector holding all the bids read
+ */
+vector<Bid> readBids(string csvPath) {
+    vector<Bid> bids;
 
-            //cout << bid.bidId << ": " << bid.title << " | " << bid.fund << " | " << bid.amount << endl;
+    MappedCsv file(csvPath);
+    if (!file.IsOpen()) {
+        std::cerr << "Unable to open " << csvPath << std::endl;
+        return bids;
+    }
 
-            // add this bid to the end
-            list->Append(bid);
+    bids.reserve(file.EstimateRows());
+    file.ForEachRow([&](const CsvRow& row) {
+        if (row.Size() >= 9) {
+            bids.push_back(bidFromRow(row));
         }
-    } catch (csv::Error &e) {
-        std::cerr << e.what() << std::endl;
+    });
+    return bids;
+}
+
+/**
+ * Load the bids into a node-per-bid list and an unrolled list,
+ * then time a full scan (totalling the amounts) and a batch of
+ * searches for random bids in each. The scan is also timed over
+ * the plain vector the bids were read into, as the best case.
+ *
+ * @param csvPath the path to the CSV file to load
+ */
+void benchmarkScan(string csvPath) {
+    vector<Bid> bids = readBids(csvPath);
+    if (bids.empty()) {
+        return;
+    }
+
+    const int searchCount = 1000;
+    vector<string> keys;
+    mt19937 random(179);
+    for (int i = 0; i < searchCount; i++) {
+        keys.push_back(bids[random() % bids.size()].bidId);
+    }
+
+    LinkedList list;
+    UnrolledLinkedList unrolled;
+
+    auto start = chrono::steady_clock::now();
+    for (const Bid& bid : bids) {
+        list.Append(bid);
+    }
+    double listAppendSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    for (const Bid& bid : bids) {
+        unrolled.Append(bid);
+    }
+    double unrolledAppendSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    double total = 0;
+    start = chrono::steady_clock::now();
+    for (const Bid& bid : bids) {
+        total += bid.amount;
+    }
+    double vectorScanSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    list.ForEach([&](const Bid& bid) { total += bid.amount; });
+    double listScanSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    unrolled.ForEach([&](const Bid& bid) { total += bid.amount; });
+    double unrolledScanSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    int found = 0;
+    start = chrono::steady_clock::now();
+    for (const string& key : keys) {
+        found += list.Search(key).amount != -1;
+    }
+    double listSearchSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    for (const string& key : keys) {
+        found += unrolled.Search(key).amount != -1;
+    }
+    double unrolledSearchSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << bids.size() << " bids, " << searchCount << " searches, " << found << " found, scans totalling " << total << endl;
+    cout << "vector   scan: " << vectorScanSeconds << " seconds" << endl;
+    cout << "list     append: " << listAppendSeconds << " seconds | scan: " << listScanSeconds << " seconds | search: " << listSearchSeconds << " seconds" << endl;
+    cout << "unrolled append: " << unrolledAppendSeconds << " seconds | scan: " << unrolledScanSeconds << " seconds | search: " << unrolledSearchSeconds << " seconds" << endl;
+}
+
+/**
+ * Time searches in the node-per-bid list against the skip list,
+ * then time concurrent ingest, with each thread inserting its
+ * share of the bids and searching for a random bid after every
+ * insert, into a skip list behind a mutex and into the lock-free
+ * skip list.
+ *
+ * @param csvPath the path to the CSV file to load
+ */
+void benchmarkSkipList(string csvPath) {
+    vector<Bid> bids = readBids(csvPath);
+    if (bids.empty()) {
+        return;
+    }
+
+    const int searchCount = 1000;
+    vector<string> keys;
+    mt19937 random(179);
+    for (int i = 0; i < searchCount; i++) {
+        keys.push_back(bids[random() % bids.size()].bidId);
+    }
+
+    LinkedList list;
+    SkipList skipList;
+    for (const Bid& bid : bids) {
+        list.Append(bid);
+    }
+    auto start = chrono::steady_clock::now();
+    for (const Bid& bid : bids) {
+        skipList.Insert(bid);
+    }
+    double skipInsertSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    int found = 0;
+    start = chrono::steady_clock::now();
+    for (const string& key : keys) {
+        found += list.Search(key).amount != -1;
+    }
+    double listSearchSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    for (const string& key : keys) {
+        found += skipList.Search(key).amount != -1;
+    }
+    double skipSearchSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << bids.size() << " bids, " << searchCount << " searches, " << found << " found" << endl;
+    cout << "list      search: " << listSearchSeconds << " seconds" << endl;
+    cout << "skip list search: " << skipSearchSeconds << " seconds | ordered insert of every bid: " << skipInsertSeconds << " seconds" << endl;
+
+    for (unsigned int threadCount : { 1, 2, 4, 8 }) {
+        SkipList lockedList;
+        mutex lock;
+        ConcurrentSkipList concurrentList;
+
+        // each thread inserts every threadCount-th bid, searching for a random bid after each
+        auto ingest = [&](auto insertAndSearch) {
+            vector<thread> threads;
+            auto begin = chrono::steady_clock::now();
+            for (unsigned int t = 0; t < threadCount; t++) {
+                threads.emplace_back([&, t]() {
+                    mt19937 threadRandom(179 + t);
+                    for (size_t i = t; i < bids.size(); i += threadCount) {
+                        insertAndSearch(bids[i], bids[threadRandom() % bids.size()].bidId);
+                    }
+                });
+            }
+            for (thread& worker : threads) {
+                worker.join();
+            }
+            return chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+        };
+
+        double lockedSeconds = ingest([&](const Bid& bid, const string& key) {
+            lock_guard<mutex> guard(lock);
+            lockedList.Insert(bid);
+            lockedList.Search(key);
+        });
+        double lockFreeSeconds = ingest([&](const Bid& bid, const string& key) {
+            concurrentList.Insert(bid);
+            concurrentList.Search(key);
+        });
+
+        cout << threadCount << " threads | mutex: " << lockedSeconds << " seconds"
+             << " | lock-free: " << lockFreeSeconds << " seconds, " << concurrentList.Size() << " bids" << endl;
+    }
+}
+
+/**
+ * Load the bids into a new list with loadBids on 1, 2, 4 and 8
+ * threads, and report rows and bytes read per second for each
+ *
+ * @param csvPath the path to the CSV file to load
+ */
+void benchmarkLoad(string csvPath) {
+    size_t fileBytes = MappedCsv(csvPath).Size();
+    for (unsigned int threadCount : { 1, 2, 4, 8 }) {
+        LinkedList list;
+
+        auto start = chrono::steady_clock::now();
+        loadBids(csvPath, &list, threadCount);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << "threads: " << threadCount << " | rows/sec: " << (unsigned long long)(list.Size() / seconds)
+             << " | GB/s: " << fileBytes / seconds / 1e9 << endl;
     }
 }
 
@@ -302,6 +1377,9 @@ int main(int argc, char* argv[]) {
         cout << "  3. Display All Bids" << endl;
         cout << "  4. Find Bid" << endl;
         cout << "  5. Remove Bid" << endl;
+        cout << "  6. Scan Benchmark" << endl;
+        cout << "  7. Skip List Benchmark" << endl;
+        cout << "  8. Load Benchmark" << endl;
         cout << "  9. Exit" << endl;
         cout << "Enter choice: ";
         cin >> choice;
@@ -317,7 +1395,7 @@ int main(int argc, char* argv[]) {
         case 2:
             ticks = clock();
 
-            loadBids(csvPath, &bidList);
+            loadBids(csvPath, &bidList, max(thread::hardware_concurrency(), 1u));
 
             cout << bidList.Size() << " bids read" << endl;
 
@@ -355,6 +1433,21 @@ int main(int argc, char* argv[]) {
         case 5:
             bidList.Remove(bidKey);
 
+            break;
+
+        case 6:
+            benchmarkScan(csvPath);
+
+            break;
+
+        case 7:
+            benchmarkSkipList(csvPath);
+
+            break;
+
+        case 8:
+            benchmarkLoad(csvPath);
+
             break;
         }
     }
@@ -0,0 +1,432 @@
+//============================================================================
+// Name        : MappedCsv.hpp
+// Description : Memory-mapped CSV reader shared by the bid programs
+//============================================================================
+
+#ifndef MAPPEDCSV_HPP
+#define MAPPEDCSV_HPP
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//============================================================================
+// CSV Row class definition
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement one row of a mapped CSV file.
+ *
+ * Each field is a view of its bytes in the mapping, quotes and
+ * all. Nothing is copied or unquoted until Text or Number is asked
+ * for that field, so the columns a program does not use cost no
+ * more than the scan that finds their commas.
+ */
+class CsvRow {
+
+private:
+
+	std::vector< std::string_view > m_fields;
+
+	friend class MappedCsv;
+
+public:
+	size_t Size() const;
+	std::string_view Raw(size_t column) const;			//The field as it is in the file, quotes included.
+	std::string Text(size_t column) const;				//The field's text, without quotes.
+	double Number(size_t column, char strip) const;		//The field as a number, ignoring every strip character, like strToDouble.
+};
+
+inline size_t CsvRow::Size() const {
+	return m_fields.size();
+}
+
+inline std::string_view CsvRow::Raw(size_t column) const {
+	return m_fields[column];
+}
+
+/**
+ * Copy a field out of the mapping. A field with no quotes in it,
+ * which is nearly all of them, is copied as is. Otherwise quotes
+ * are dropped, and "" inside quotes is one quote.
+ */
+inline std::string CsvRow::Text(size_t column) const {
+	std::string_view raw = m_fields[column];
+	if (raw.find('"') == std::string_view::npos)
+		return std::string(raw);
+
+	std::string text;
+	text.reserve(raw.size());
+	bool quoted = false;
+	for (size_t i = 0; i < raw.size(); i++) {
+		if (raw[i] != '"')
+			text += raw[i];
+		else if (quoted && i + 1 < raw.size() && raw[i + 1] == '"') {
+			text += '"';
+			i++;
+		}
+		else
+			quoted = !quoted;
+	}
+	return text;
+}
+
+/**
+ * Read a field as a number. Short fields, which amounts always are,
+ * are copied to the stack without the strip characters and quotes,
+ * so nothing is allocated.
+ */
+inline double CsvRow::Number(size_t column, char strip) const {
+	std::string_view raw = m_fields[column];
+	char digits[64];
+	if (raw.size() >= sizeof(digits)) {
+		std::string text = Text(column);
+		text.erase(std::remove(text.begin(), text.end(), strip), text.end());
+		return atof(text.c_str());
+	}
+
+	size_t length = 0;
+	for (char c : raw) {
+		if (c != strip && c != '"')
+			digits[length++] = c;
+	}
+	digits[length] = '\0';
+	return atof(digits);
+}
+
+//============================================================================
+// Mapped CSV class definition
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement reading a CSV file mapped into memory.
+ *
+ * The whole file is mapped read only and rows are split in place,
+ * so loading costs the page faults that bring the file in, plus
+ * the strings the program keeps. The kernel is told the file will
+ * be read front to back, so it reads ahead in large blocks.
+ *
+ * Quoting follows the usual rules: a field in double quotes may
+ * hold commas and line breaks, and "" inside it is one quote.
+ */
+class MappedCsv {
+
+private:
+
+	const char* m_data;
+	size_t m_size;
+	bool m_open;
+
+	//Private helper functions used to split the file into chunks of rows.
+	size_t countQuotes(size_t begin, size_t end) const;
+	size_t nextRowStart(size_t offset, bool quoted) const;
+
+public:
+	explicit MappedCsv(const std::string& path);
+	virtual ~MappedCsv();
+	MappedCsv(const MappedCsv&) = delete;
+	MappedCsv& operator=(const MappedCsv&) = delete;
+	bool IsOpen() const;
+	size_t Size() const;
+	size_t EstimateRows() const;						//Line breaks in the file: at least the rows, header included.
+	bool ReadRow(size_t& offset, CsvRow& row) const;	//Split the row at offset, and move offset to the next. False at the end of the file.
+	size_t HeaderEnd() const;							//Where the first row after the header starts.
+	std::vector<size_t> SplitRows(unsigned int chunkCount) const;
+	template <typename Visit> size_t ForEachRow(Visit visit) const;
+	template <typename Visit> size_t ForEachRowParallel(unsigned int threadCount, Visit visit) const;
+	template <typename Record, typename Convert> std::vector< std::vector<Record> > ReadBatches(unsigned int threadCount, Convert convert) const;
+};
+
+/**
+ * Map a CSV file. An empty file maps nothing, but is open.
+ */
+inline MappedCsv::MappedCsv(const std::string& path) : m_data(nullptr), m_size(0), m_open(false) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat status;
+	if (fstat(fd, &status) == 0) {
+		m_size = (size_t)status.st_size;
+		m_open = true;
+		if (m_size > 0) {
+			void* mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapping == MAP_FAILED) {
+				m_size = 0;
+				m_open = false;
+			}
+			else {
+				//Advice is one value per call, not flags. Both are hints only, so a failure is ignored.
+				(void)madvise(mapping, m_size, MADV_SEQUENTIAL);
+				(void)madvise(mapping, m_size, MADV_WILLNEED);
+				m_data = (const char*)mapping;
+			}
+		}
+	}
+
+	//The mapping stays valid after the file is closed.
+	close(fd);
+}
+
+inline MappedCsv::~MappedCsv() {
+	if (m_data != nullptr)
+		munmap((void*)m_data, m_size);
+}
+
+inline bool MappedCsv::IsOpen() const {
+	return m_open;
+}
+
+inline size_t MappedCsv::Size() const {
+	return m_size;
+}
+
+/**
+ * Count the line breaks with memchr, which is far faster than
+ * splitting rows. A quoted line break is counted too, so this is
+ * an upper bound, good for sizing a container up front.
+ */
+inline size_t MappedCsv::EstimateRows() const {
+	size_t count = 0;
+	const char* position = m_data;
+	const char* end = m_data + m_size;
+	while (position < end) {
+		const char* lineEnd = (const char*)memchr(position, '\n', end - position);
+		if (lineEnd == nullptr) {
+			count++;
+			break;
+		}
+		count++;
+		position = lineEnd + 1;
+	}
+	return count;
+}
+
+/**
+ * Split the row starting at offset into fields
+ *
+ * @param offset Where the row starts. Moved to where the next row starts.
+ * @param row Filled with views of the row's fields
+ * @return False when offset is already at the end of the file
+ */
+inline bool MappedCsv::ReadRow(size_t& offset, CsvRow& row) const {
+	row.m_fields.clear();
+	if (offset >= m_size)
+		return false;
+
+	const char* position = m_data + offset;
+	const char* end = m_data + m_size;
+	const char* fieldStart = position;
+	bool quoted = false;
+	while (position < end) {
+		char c = *position;
+		if (quoted) {
+			//Inside quotes only a quote matters. A doubled quote toggles twice, which comes to the same thing.
+			if (c == '"')
+				quoted = false;
+			position++;
+		}
+		else if (c == ',') {
+			row.m_fields.emplace_back(fieldStart, position - fieldStart);
+			fieldStart = ++position;
+		}
+		else if (c == '\n')
+			break;
+		else {
+			if (c == '"')
+				quoted = true;
+			position++;
+		}
+	}
+
+	//The last field ends at the line break, less any carriage return before it.
+	const char* fieldEnd = position;
+	if (fieldEnd > fieldStart && fieldEnd[-1] == '\r')
+		fieldEnd--;
+	row.m_fields.emplace_back(fieldStart, fieldEnd - fieldStart);
+
+	offset = (position < end ? position + 1 : end) - m_data;
+	return true;
+}
+
+/**
+ * Call visit(const CsvRow&) with every row after the header, in
+ * file order. One CsvRow is reused throughout, so a row's views
+ * are only valid during its call.
+ *
+ * @return The number of rows visited
+ */
+template <typename Visit>
+size_t MappedCsv::ForEachRow(Visit visit) const {
+	CsvRow row;
+	size_t offset = 0;
+	size_t count = 0;
+
+	//The first row is the header.
+	ReadRow(offset, row);
+	while (ReadRow(offset, row)) {
+		visit(row);
+		count++;
+	}
+	return count;
+}
+
+/**
+ * Count the quotes in part of the file
+ */
+inline size_t MappedCsv::countQuotes(size_t begin, size_t end) const {
+	size_t count = 0;
+	const char* position = m_data + begin;
+	const char* last = m_data + end;
+	while (position < last) {
+		position = (const char*)memchr(position, '"', last - position);
+		if (position == nullptr)
+			break;
+		count++;
+		position++;
+	}
+	return count;
+}
+
+/**
+ * Where the first row starting after offset begins: just past the
+ * first line break that is not inside quotes, or the end of the file
+ *
+ * @param offset Where to start looking
+ * @param quoted Whether offset is inside quotes
+ */
+inline size_t MappedCsv::nextRowStart(size_t offset, bool quoted) const {
+	for (size_t i = offset; i < m_size; i++) {
+		if (m_data[i] == '"')
+			quoted = !quoted;
+		else if (m_data[i] == '\n' && !quoted)
+			return i + 1;
+	}
+	return m_size;
+}
+
+inline size_t MappedCsv::HeaderEnd() const {
+	CsvRow header;
+	size_t offset = 0;
+	ReadRow(offset, header);
+	return offset;
+}
+
+/**
+ * Split the rows after the header into chunks of about the same
+ * number of bytes, each starting at a row boundary.
+ *
+ * A line break only ends a row outside quotes, and whether a byte
+ * is inside quotes depends on every quote before it. So the quotes
+ * in each even share of the file are counted first, on a thread
+ * per share. An odd number of quotes before a share's nominal start
+ * means it is inside a quoted field, and the chunk starts after the
+ * first line break past it that is outside quotes. A doubled quote
+ * counts twice, so it never changes the answer.
+ *
+ * @param chunkCount How many chunks to split into
+ * @return chunkCount + 1 offsets: chunk i is the rows from entry i up to entry i + 1
+ */
+inline std::vector<size_t> MappedCsv::SplitRows(unsigned int chunkCount) const {
+	chunkCount = std::max(chunkCount, 1u);
+	size_t begin = HeaderEnd();
+	auto nominalStart = [&](size_t chunk) { return begin + (m_size - begin) * chunk / chunkCount; };
+
+	std::vector<size_t> quotes(chunkCount);
+	std::vector<std::thread> counters;
+	for (unsigned int chunk = 1; chunk < chunkCount; chunk++) {
+		counters.emplace_back([&, chunk]() { quotes[chunk] = countQuotes(nominalStart(chunk), nominalStart(chunk + 1)); });
+	}
+	quotes[0] = countQuotes(begin, nominalStart(1));
+	for (std::thread& counter : counters) {
+		counter.join();
+	}
+
+	std::vector<size_t> bounds(chunkCount + 1);
+	bounds[0] = begin;
+	bounds[chunkCount] = m_size;
+	bool quoted = false;
+	for (unsigned int chunk = 1; chunk < chunkCount; chunk++) {
+		quoted ^= (quotes[chunk - 1] & 1) != 0;
+		bounds[chunk] = std::max(nextRowStart(nominalStart(chunk), quoted), bounds[chunk - 1]);
+	}
+	return bounds;
+}
+
+/**
+ * Split the rows after the header into a chunk per thread, and call
+ * visit(unsigned int chunk, const CsvRow&) with every row of each
+ * chunk on that chunk's own thread, in file order within the chunk.
+ * Chunk 0 is the calling thread's. Every row is visited exactly as
+ * ForEachRow would, since chunks start on the same boundaries a
+ * front to back read finds.
+ *
+ * @param threadCount Threads to read with, including the caller
+ * @return The number of rows visited
+ */
+template <typename Visit>
+size_t MappedCsv::ForEachRowParallel(unsigned int threadCount, Visit visit) const {
+	threadCount = std::max(threadCount, 1u);
+	std::vector<size_t> bounds = SplitRows(threadCount);
+	std::vector<size_t> counts(threadCount);
+
+	auto readChunk = [&](unsigned int chunk) {
+		CsvRow row;
+		size_t offset = bounds[chunk];
+		size_t count = 0;
+		while (offset < bounds[chunk + 1] && ReadRow(offset, row)) {
+			visit(chunk, row);
+			count++;
+		}
+		counts[chunk] = count;
+	};
+
+	std::vector<std::thread> readers;
+	for (unsigned int chunk = 1; chunk < threadCount; chunk++) {
+		readers.emplace_back(readChunk, chunk);
+	}
+	readChunk(0);
+	for (std::thread& reader : readers) {
+		reader.join();
+	}
+
+	size_t count = 0;
+	for (size_t chunkCount : counts) {
+		count += chunkCount;
+	}
+	return count;
+}
+
+/**
+ * Convert the rows after the header into records on several
+ * threads. Each thread calls convert(const CsvRow&, std::vector<Record>&)
+ * for the rows of its chunk, and may add a record to the batch it
+ * is handed or skip the row. The batches come back in file order,
+ * so appending them one after another gives the records in the
+ * order a single thread would have made them.
+ *
+ * @param threadCount Threads to read with, including the caller
+ * @return A batch of records per thread
+ */
+template <typename Record, typename Convert>
+std::vector< std::vector<Record> > MappedCsv::ReadBatches(unsigned int threadCount, Convert convert) const {
+	threadCount = std::max(threadCount, 1u);
+	std::vector< std::vector<Record> > batches(threadCount);
+	ForEachRowParallel(threadCount, [&](unsigned int chunk, const CsvRow& row) {
+		convert(row, batches[chunk]);
+	});
+	return batches;
+}
+
+#endif
@@ -9,10 +9,24 @@
 //============================================================================
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
 #include <time.h>
+#include <vector>
 
-#include "CSVparser.hpp"
+#include "MappedCsv.hpp"
 
 using namespace std;
 
@@ -20,6 +34,27 @@ using namespace std;
 // Global definitions visible to all methods and classes
 //============================================================================
 
+//Ranges of this many bids or fewer are sorted sequentially rather than split into more tasks.
+const int PARALLEL_SORT_CUTOFF = 4096;
+
+//Ranges of this many bids or fewer are finished with insertion sort.
+const int INSERTION_SORT_CUTOFF = 16;
+
+//Ranges of more bids than this take the ninther, rather than the median of three, as the pivot.
+const int NINTHER_THRESHOLD = 128;
+
+//Most bids the sort benchmark runs the quadratic selection sort on.
+const size_t SELECTION_SORT_BENCHMARK_LIMIT = 50000;
+
+//Memory the external sort may use for bids and buffers, unless --memory says otherwise.
+const size_t EXTERNAL_SORT_DEFAULT_MEMORY_MB = 256;
+
+//Size of the block the external sort reads its CSV input in, and writes each run with.
+const size_t EXTERNAL_SORT_IO_BUFFER = 1 << 20;
+
+//Smallest read buffer a run gets during the merge, however many runs there are.
+const size_t EXTERNAL_SORT_MIN_BUFFER = 64 << 10;
+
 // forward declarations
 double strToDouble(string str, char ch);
 
@@ -34,6 +69,505 @@ struct Bid {
     }
 };
 
+//============================================================================
+// Work Stealing Pool class definition
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement a pool of threads that share tasks by work stealing.
+ *
+ * Every thread has its own queue of tasks. A thread pushes the
+ * tasks it creates onto the back of its own queue and takes work
+ * from the back too, so it keeps working on what it just split
+ * off, which is still in its cache. A thread that runs out steals
+ * from the front of another thread's queue, which holds that
+ * thread's oldest, and so usually largest, tasks. The thread that
+ * created the pool has a queue too and works alongside the pool
+ * threads while it waits.
+ */
+class WorkStealingPool {
+
+private:
+
+	//A thread's queue, on cache lines of its own so neighbouring locks do not false share.
+	struct alignas(64) Worker {
+		mutex lock;
+		deque< function<void()> > tasks;
+	};
+
+	vector< unique_ptr< Worker > > m_workers;
+	vector< thread > m_threads;
+
+	//Tasks submitted and not yet finished, and tasks sitting in a queue.
+	atomic< size_t > m_pending;
+	atomic< size_t > m_queued;
+	atomic< bool > m_stop;
+
+	//Idle pool threads sleep here until a task is queued.
+	mutex m_sleepLock;
+	condition_variable m_wake;
+
+	//Private helper functions used by the threads.
+	size_t selfIndex();
+	bool runOne(size_t self);
+	void workerLoop(size_t index);
+
+public:
+	explicit WorkStealingPool(unsigned int threadCount);
+	virtual ~WorkStealingPool();
+	void Submit(function<void()> task);				//Queue a task. May be called from inside a task.
+	void Wait();									//Help run tasks until every submitted task has finished.
+};
+
+//The pool the current thread works for, and the index of its queue there.
+thread_local WorkStealingPool* t_pool = nullptr;
+thread_local size_t t_workerIndex = 0;
+
+/**
+ * Start a pool. The calling thread counts as one of the threads.
+ *
+ * @param threadCount Total threads working on the tasks, including the caller
+ */
+WorkStealingPool::WorkStealingPool(unsigned int threadCount) : m_pending(0), m_queued(0), m_stop(false) {
+	threadCount = max(threadCount, 1u);
+	for (unsigned int i = 0; i < threadCount; i++) {
+		m_workers.push_back(make_unique<Worker>());
+	}
+	for (unsigned int i = 1; i < threadCount; i++) {
+		m_threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+	}
+}
+
+/**
+ * Stop the pool threads once they are idle
+ */
+WorkStealingPool::~WorkStealingPool() {
+	Wait();
+	{
+		lock_guard<mutex> guard(m_sleepLock);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (thread& worker : m_threads) {
+		worker.join();
+	}
+}
+
+/**
+ * Index of the current thread's queue. Threads outside the pool share queue 0 with the pool's creator.
+ */
+size_t WorkStealingPool::selfIndex() {
+	return t_pool == this ? t_workerIndex : 0;
+}
+
+/**
+ * Queue a task on the current thread's own queue
+ *
+ * @param task The task to run
+ */
+void WorkStealingPool::Submit(function<void()> task) {
+	m_pending.fetch_add(1);
+	Worker& worker = *m_workers[selfIndex()];
+	{
+		lock_guard<mutex> guard(worker.lock);
+		worker.tasks.push_back(std::move(task));
+	}
+
+	m_queued.fetch_add(1);
+	m_wake.notify_one();
+}
+
+/**
+ * Run one task: the newest from the thread's own queue, or failing
+ * that the oldest from another thread's queue
+ *
+ * @param self Index of the current thread's queue
+ * @return Whether a task was run
+ */
+bool WorkStealingPool::runOne(size_t self) {
+	function<void()> task;
+	for (size_t i = 0; i < m_workers.size() && !task; i++) {
+		Worker& worker = *m_workers[(self + i) % m_workers.size()];
+		lock_guard<mutex> guard(worker.lock);
+		if (worker.tasks.empty())
+			continue;
+		if (i == 0) {
+			task = std::move(worker.tasks.back());
+			worker.tasks.pop_back();
+		}
+		else {
+			task = std::move(worker.tasks.front());
+			worker.tasks.pop_front();
+		}
+	}
+	if (!task)
+		return false;
+
+	m_queued.fetch_sub(1);
+	task();
+	m_pending.fetch_sub(1);
+	return true;
+}
+
+/**
+ * Body of each pool thread: run tasks, and sleep while there are none
+ *
+ * @param index The thread's queue
+ */
+void WorkStealingPool::workerLoop(size_t index) {
+	t_pool = this;
+	t_workerIndex = index;
+	while (true) {
+		if (runOne(index))
+			continue;
+
+		unique_lock<mutex> guard(m_sleepLock);
+		if (m_stop)
+			return;
+		m_wake.wait_for(guard, chrono::milliseconds(1), [this]() { return m_stop || m_queued.load() > 0; });
+	}
+}
+
+/**
+ * Help run tasks until every submitted task, including ones
+ * submitted by other tasks in the meantime, has finished
+ */
+void WorkStealingPool::Wait() {
+	size_t self = selfIndex();
+	while (m_pending.load() > 0) {
+		if (!runOne(self))
+			this_thread::yield();
+	}
+}
+
+//============================================================================
+// CSV Stream Reader class definition
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement a CSV reader that holds one row at a time.
+ *
+ * The external sort reads its input through this rather than
+ * MappedCsv: mapped pages stay resident until the kernel is short
+ * of memory, which would blur the sort's memory budget. This reads
+ * the file in large sequential blocks into one reused buffer and
+ * splits rows as it goes, following the same quoting rules: a
+ * field in double quotes may hold commas and line breaks, and ""
+ * inside it is one quote.
+ */
+class CsvStreamReader {
+
+private:
+
+	FILE* m_file;
+	vector< char > m_buffer;
+
+	//Next unread byte of the buffer, and one past the last byte read into it.
+	size_t m_position;
+	size_t m_end;
+
+	//Private helper function used to read the file a block at a time.
+	int nextChar();
+
+public:
+	explicit CsvStreamReader(const string& path);
+	virtual ~CsvStreamReader();
+	bool IsOpen() const;
+	bool NextRow(vector<string>& fields);				//Read the next row's fields. False at the end of the file.
+};
+
+/**
+ * Open a CSV file for reading
+ */
+CsvStreamReader::CsvStreamReader(const string& path) : m_buffer(EXTERNAL_SORT_IO_BUFFER), m_position(0), m_end(0) {
+	m_file = fopen(path.c_str(), "rb");
+}
+
+CsvStreamReader::~CsvStreamReader() {
+	if (m_file != nullptr)
+		fclose(m_file);
+}
+
+bool CsvStreamReader::IsOpen() const {
+	return m_file != nullptr;
+}
+
+/**
+ * The next byte of the file, or EOF
+ */
+int CsvStreamReader::nextChar() {
+	if (m_position == m_end) {
+		m_end = fread(m_buffer.data(), 1, m_buffer.size(), m_file);
+		m_position = 0;
+		if (m_end == 0)
+			return EOF;
+	}
+	return (unsigned char)m_buffer[m_position++];
+}
+
+/**
+ * Read the next row
+ *
+ * @param fields Filled with the row's fields
+ * @return False when there are no more rows
+ */
+bool CsvStreamReader::NextRow(vector<string>& fields) {
+	fields.clear();
+	if (m_file == nullptr)
+		return false;
+
+	int c = nextChar();
+	if (c == EOF)
+		return false;
+
+	string field;
+	bool quoted = false;
+	while (true) {
+		if (quoted) {
+			if (c == EOF)
+				break;
+			if (c == '"') {
+				//Either the closing quote, or the first of a doubled one.
+				c = nextChar();
+				if (c == '"')
+					field += '"';
+				else {
+					quoted = false;
+					continue;
+				}
+			}
+			else
+				field += (char)c;
+		}
+		else if (c == '"')
+			quoted = true;
+		else if (c == ',') {
+			fields.push_back(std::move(field));
+			field.clear();
+		}
+		else if (c == '\n' || c == EOF)
+			break;
+		else if (c != '\r')
+			field += (char)c;
+		c = nextChar();
+	}
+	fields.push_back(std::move(field));
+	return true;
+}
+
+//============================================================================
+// Sorted Run File class definitions
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement writing bids to a run file of the external sort.
+ *
+ * The format is compact binary: for each bid, the id, title and
+ * fund as a 32 bit length and the bytes, then the amount as an 8
+ * byte double, then the bid's whole input row the same way, so the
+ * merge can write every column back out. Writes go through a large
+ * stdio buffer, so the file is written in big sequential blocks.
+ */
+class RunWriter {
+
+private:
+
+	FILE* m_file;
+	vector< char > m_buffer;
+
+	void writeString(const string& text);
+
+public:
+	RunWriter(const string& path, size_t bufferSize);
+	virtual ~RunWriter();
+	bool IsOpen() const;
+	void Write(const Bid& bid, const string& row);
+};
+
+RunWriter::RunWriter(const string& path, size_t bufferSize) : m_buffer(bufferSize) {
+	m_file = fopen(path.c_str(), "wb");
+	if (m_file != nullptr)
+		setvbuf(m_file, m_buffer.data(), _IOFBF, m_buffer.size());
+}
+
+RunWriter::~RunWriter() {
+	if (m_file != nullptr)
+		fclose(m_file);
+}
+
+bool RunWriter::IsOpen() const {
+	return m_file != nullptr;
+}
+
+void RunWriter::writeString(const string& text) {
+	uint32_t length = (uint32_t)text.size();
+	fwrite(&length, sizeof(length), 1, m_file);
+	fwrite(text.data(), 1, length, m_file);
+}
+
+void RunWriter::Write(const Bid& bid, const string& row) {
+	writeString(bid.bidId);
+	writeString(bid.title);
+	writeString(bid.fund);
+	fwrite(&bid.amount, sizeof(bid.amount), 1, m_file);
+	writeString(row);
+}
+
+/**
+ * Define a class containing data members and methods to
+ * implement reading back a run file, one bid at a time.
+ */
+class RunReader {
+
+private:
+
+	FILE* m_file;
+	vector< char > m_buffer;
+
+	//The bid at the front of the run and its input row, valid while m_valid is set.
+	Bid m_current;
+	string m_currentRow;
+	bool m_valid;
+
+	bool readString(string& text);
+
+public:
+	RunReader(const string& path, size_t bufferSize);
+	virtual ~RunReader();
+	bool Valid() const;								//Whether there is a current bid, false once the run is used up.
+	const Bid& Current() const;
+	Bid& Current();
+	const string& CurrentRow() const;				//The current bid's input row, as a line of CSV without the line break.
+	void Next();									//Move on to the next bid in the run.
+};
+
+RunReader::RunReader(const string& path, size_t bufferSize) : m_buffer(bufferSize), m_valid(false) {
+	m_file = fopen(path.c_str(), "rb");
+	if (m_file != nullptr)
+		setvbuf(m_file, m_buffer.data(), _IOFBF, m_buffer.size());
+	Next();
+}
+
+RunReader::~RunReader() {
+	if (m_file != nullptr)
+		fclose(m_file);
+}
+
+bool RunReader::Valid() const {
+	return m_valid;
+}
+
+const Bid& RunReader::Current() const {
+	return m_current;
+}
+
+Bid& RunReader::Current() {
+	return m_current;
+}
+
+const string& RunReader::CurrentRow() const {
+	return m_currentRow;
+}
+
+bool RunReader::readString(string& text) {
+	uint32_t length;
+	if (fread(&length, sizeof(length), 1, m_file) != 1)
+		return false;
+	text.resize(length);
+	return fread(text.data(), 1, length, m_file) == length;
+}
+
+void RunReader::Next() {
+	m_valid = m_file != nullptr
+		&& readString(m_current.bidId)
+		&& readString(m_current.title)
+		&& readString(m_current.fund)
+		&& fread(&m_current.amount, sizeof(m_current.amount), 1, m_file) == 1
+		&& readString(m_currentRow);
+}
+
+//============================================================================
+// Loser Tree class definition
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement a loser tree over the runs of a k-way merge.
+ *
+ * Each internal node remembers the run that lost the match played
+ * there, and node 0 the overall winner, the run with the lowest
+ * title at its front. After the winner's run moves on, only the
+ * matches on the path from its leaf to the root are replayed, so
+ * each bid merged costs log2(k) comparisons and no heap shuffling.
+ * A used up run loses every match.
+ */
+class LoserTree {
+
+private:
+
+	vector< RunReader* > m_runs;
+
+	//Loser at each internal node 1 .. k - 1, winner at 0. -1 stands for a run that beats everything, used only while building.
+	vector< int > m_losers;
+
+	bool beats(int a, int b) const;
+	void replay(int run);
+
+public:
+	explicit LoserTree(vector<RunReader*> runs);
+	int Winner() const;								//The run holding the lowest bid, or -1 when every run is used up.
+	void Advance();									//Move the winning run on, and find the new winner.
+};
+
+/**
+ * Build the tree over the runs, each already at its first bid
+ */
+LoserTree::LoserTree(vector<RunReader*> runs) : m_runs(std::move(runs)), m_losers(max<size_t>(m_runs.size(), 1), -1) {
+
+	//Every node starts holding -1, which wins every match, and each run is played in. By the time the last run is, every -1 has been knocked out.
+	for (int run = (int)m_runs.size() - 1; run >= 0; run--) {
+		replay(run);
+	}
+}
+
+/**
+ * Whether run a wins against run b: it has a bid and b does not, or its title is lower
+ */
+bool LoserTree::beats(int a, int b) const {
+	if (a < 0 || b < 0)
+		return a < 0;
+	if (!m_runs[a]->Valid() || !m_runs[b]->Valid())
+		return m_runs[a]->Valid();
+	return m_runs[a]->Current().title < m_runs[b]->Current().title;
+}
+
+/**
+ * Play a run's way up from its leaf to the root, leaving the loser of each match behind
+ */
+void LoserTree::replay(int run) {
+	int winner = run;
+	for (size_t node = (run + m_runs.size()) / 2; node > 0; node /= 2) {
+		if (beats(m_losers[node], winner))
+			swap(m_losers[node], winner);
+	}
+	m_losers[0] = winner;
+}
+
+int LoserTree::Winner() const {
+	if (m_runs.empty() || !m_runs[m_losers[0]]->Valid())
+		return -1;
+	return m_losers[0];
+}
+
+void LoserTree::Advance() {
+	int winner = m_losers[0];
+	m_runs[winner]->Next();
+	replay(winner);
+}
+
 //============================================================================
 // Static methods used for testing
 //============================================================================
@@ -77,134 +611,298 @@ Bid getBid() {
 }
 
 /**
- * Load a CSV file containing bids into a container
+ * Make a bid from a row of the CSV file. Only the four columns a
+ * bid keeps are copied out of the mapping.
+ */
+Bid bidFromRow(const CsvRow& row) {
+    Bid bid;
+    bid.bidId = row.Text(1);
+    bid.title = row.Text(0);
+    bid.fund = row.Text(8);
+    bid.amount = row.Number(4, '$');
+    return bid;
+}
+
+/**
+ * Add the bid in a row of the CSV file to a batch, skipping a row
+ * too short to hold one
+ */
+void appendBidRow(const CsvRow& row, vector<Bid>& batch) {
+    if (row.Size() >= 9) {
+        batch.push_back(bidFromRow(row));
+    }
+}
+
+/**
+ * Load a CSV file containing bids into a container. The file is
+ * split into a chunk of rows per thread, each thread converts its
+ * chunk into a batch of bids, and the batches are joined in file
+ * order.
  *
  * @param csvPath the path to the CSV file to load
+ * @param threadCount number of threads to convert rows on, including the caller
  * @return a container holding all the bids read
  */
-vector<Bid> loadBids(string csvPath) {
+vector<Bid> loadBids(string csvPath, unsigned int threadCount = 1) {
     cout << "Loading CSV file " << csvPath << endl;
 
-    // Define a vector data structure to hold a collection of bids.
-    vector<Bid> bids;
-
-    // initialize the CSV Parser using the given path
-    csv::Parser file = csv::Parser(csvPath);
-
-    try {
-        // loop to read rows of a CSV file
-        for (int i = 0; i < file.rowCount(); i++) {
-
-            // Create a data structure and add to the collection of bids
-            Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][8];
-            bid.amount = strToDouble(file[i][4], '$');
+    // map the file rather than parse it into strings up front
+    MappedCsv file(csvPath);
+    if (!file.IsOpen()) {
+        std::cerr << "Unable to open " << csvPath << std::endl;
+        return vector<Bid>();
+    }
 
-            //cout << "Item: " << bid.title << ", Fund: " << bid.fund << ", Amount: " << bid.amount << endl;
+    vector< vector<Bid> > batches = file.ReadBatches<Bid>(threadCount, appendBidRow);
 
-            // push this bid to the end
-            bids.push_back(bid);
-        }
-    } catch (csv::Error &e) {
-        std::cerr << e.what() << std::endl;
+    // the first batch becomes the vector, the others move onto its end
+    size_t total = 0;
+    for (const vector<Bid>& batch : batches) {
+        total += batch.size();
+    }
+    vector<Bid> bids = std::move(batches[0]);
+    bids.reserve(total);
+    for (size_t i = 1; i < batches.size(); i++) {
+        bids.insert(bids.end(), make_move_iterator(batches[i].begin()), make_move_iterator(batches[i].end()));
     }
     return bids;
 }
 
-
-
-
-//Helper function to swap values.
+//Helper function to swap values. Swapping moves the strings rather than copying them.
 void SwapValues(Bid* xB, Bid* yB)
 {
-	Bid temp = *xB;
-	*xB = *yB;
-	*yB = temp;
+	swap(*xB, *yB);
 }
 
+/**
+ * Sort a short range of bids by title with insertion sort, which
+ * beats partitioning on a handful of bids
+ *
+ * @param bids Address of the vector<Bid> instance to be sorted
+ * @param begin Beginning index to sort
+ * @param end Ending index to sort
+ */
+void insertionSort(vector<Bid>& bids, int begin, int end) {
+	for (int i = begin + 1; i <= end; i++) {
+		if (!(bids[i].title < bids[i - 1].title))
+			continue;
+
+		//Shift the larger bids up one until the gap is where this bid belongs.
+		Bid moving = std::move(bids[i]);
+		int j = i;
+		do {
+			bids[j] = std::move(bids[j - 1]);
+			j--;
+		} while (j > begin && moving.title < bids[j - 1].title);
+		bids[j] = std::move(moving);
+	}
+}
 
+/**
+ * Move a bid down a max heap of titles until both its children are no larger
+ *
+ * @param bids Address of the vector<Bid> instance holding the heap
+ * @param begin Index of the top of the heap
+ * @param node Position in the heap of the bid to move, counting from 0
+ * @param count Number of bids in the heap
+ */
+void siftDown(vector<Bid>& bids, int begin, int node, int count) {
+	Bid moving = std::move(bids[begin + node]);
+	while (2 * node + 1 < count) {
+		int child = 2 * node + 1;
+		if (child + 1 < count && bids[begin + child].title < bids[begin + child + 1].title)
+			child++;
+		if (!(moving.title < bids[begin + child].title))
+			break;
+		bids[begin + node] = std::move(bids[begin + child]);
+		node = child;
+	}
+	bids[begin + node] = std::move(moving);
+}
 
+/**
+ * Perform a heap sort on bid title
+ * Performance: O(n log(n)) whatever the input, which is why
+ * introSort falls back to it
+ *
+ * @param bids Address of the vector<Bid> instance to be sorted
+ * @param begin Beginning index to sort
+ * @param end Ending index to sort
+ */
+void heapSort(vector<Bid>& bids, int begin, int end) {
+	int count = end - begin + 1;
+	for (int node = count / 2 - 1; node >= 0; node--) {
+		siftDown(bids, begin, node, count);
+	}
+	for (int last = count - 1; last > 0; last--) {
+		swap(bids[begin], bids[begin + last]);
+		siftDown(bids, begin, 0, last);
+	}
+}
 
+/**
+ * Index of the bid with the middle title of three
+ */
+int medianOfThree(vector<Bid>& bids, int a, int b, int c) {
+	const string& x = bids[a].title;
+	const string& y = bids[b].title;
+	const string& z = bids[c].title;
+	if (x < y)
+		return y < z ? b : (x < z ? c : a);
+	return x < z ? a : (y < z ? c : b);
+}
 
-
-
-
-
-
-
-
-
-// FIXME (2a): Implement the quick sort logic over bid.title
+/**
+ * Pick the pivot for a range: the median of the first, middle and
+ * last bids, or for a large range, the median of three such medians
+ * spread across it (Tukey's ninther). Either way sorted, reverse
+ * sorted and nearly sorted input all split near the middle.
+ *
+ * @return Index of the pivot bid
+ */
+int choosePivot(vector<Bid>& bids, int begin, int end) {
+	int midpoint = begin + (end - begin) / 2;
+	if (end - begin + 1 <= NINTHER_THRESHOLD)
+		return medianOfThree(bids, begin, midpoint, end);
+
+	int step = (end - begin + 1) / 8;
+	return medianOfThree(bids,
+		medianOfThree(bids, begin, begin + step, begin + 2 * step),
+		medianOfThree(bids, midpoint - step, midpoint, midpoint + step),
+		medianOfThree(bids, end - 2 * step, end - step, end));
+}
 
 /**
- * Partition the vector of bids into two parts, low and high
+ * Partition the vector of bids into three parts: titles below the
+ * pivot, equal to it, and above it. The equal bids are already in
+ * place, so a range full of duplicate titles is finished in one
+ * pass instead of being split again and again.
  *
  * @param bids Address of the vector<Bid> instance to be partitioned
  * @param begin Beginning index to partition
  * @param end Ending index to partition
+ * @param lessEnd Set to one past the last bid below the pivot
+ * @param greaterBegin Set to the first bid above the pivot
  */
-int partition(vector<Bid>& bids, int begin, int end) {
-	
-	//Find the midpoint (and pivot) point.
-	int midpoint = begin + (end - begin) / 2;
-	Bid pivot = bids.at(midpoint);
-	bool done = false;
-
-	//The upper and lower limits of this partition.
-	int low_bounds = begin;
-	int high_bounds = end;
+void partition(vector<Bid>& bids, int begin, int end, int& lessEnd, int& greaterBegin) {
+
+	//Only the title is needed from the pivot, and it has to be a copy since the pivot bid itself moves.
+	string pivot = bids[choosePivot(bids, begin, end)].title;
+
+	//[begin, low) is below the pivot, [low, i) equal to it, (high, end] above it, and [i, high] not looked at yet.
+	int low = begin;
+	int i = begin;
+	int high = end;
+	while (i <= high) {
+		int order = bids[i].title.compare(pivot);
+		if (order < 0) {
+			if (i != low)
+				swap(bids[low], bids[i]);
+			low++;
+			i++;
+		}
+		else if (order > 0) {
+			swap(bids[i], bids[high]);
+			high--;
+		}
+		else
+			i++;
+	}
 
-	//Loop while there are more than 1 remaining element in the partition.
-	while (!done) {
+	lessEnd = low;
+	greaterBegin = high + 1;
+}
 
-		//Lower high_bounds while pivot < the value at the higher bounds.
-		while (pivot.title < bids.at(high_bounds).title) {
-			high_bounds--;
+/**
+ * Quick sort a range on bid title, switching to insertion sort for
+ * short ranges and to heap sort once depthLimit partitions deep,
+ * which only happens when pivots keep coming out lopsided
+ *
+ * @param bids address of the vector<Bid> instance to be sorted
+ * @param begin the beginning index to sort on
+ * @param end the ending index to sort on
+ * @param depthLimit partitions left before falling back to heap sort
+ */
+void introSort(vector<Bid>& bids, int begin, int end, int depthLimit) {
+	while (end - begin + 1 > INSERTION_SORT_CUTOFF) {
+		if (depthLimit-- == 0) {
+			heapSort(bids, begin, end);
+			return;
 		}
 
-		//Raise the lower bounds while the value at the lower bounds is less than the pivot.
-		while (bids.at(low_bounds).title < pivot.title) {
-			low_bounds++;
-		}
+		int lessEnd, greaterBegin;
+		partition(bids, begin, end, lessEnd, greaterBegin);
 
-		if (low_bounds >= high_bounds)
-			done = true;
+		//Recurse into the smaller part and loop on the larger, so the stack never goes deeper than log n.
+		if (lessEnd - begin < end - greaterBegin) {
+			introSort(bids, begin, lessEnd - 1, depthLimit);
+			begin = greaterBegin;
+		}
 		else {
-
-			//Finally, swap the bids at the lower and higher bounds and update new bounds.
-			SwapValues(&bids.at(low_bounds), &bids.at(high_bounds));
-			low_bounds++;
-			high_bounds--;
+			introSort(bids, greaterBegin, end, depthLimit);
+			end = lessEnd - 1;
 		}
 	}
+	insertionSort(bids, begin, end);
+}
 
-
-	//Return the upper limit of this partition.
-	return high_bounds;
+/**
+ * Partitions a sort of count bids may go through before falling back to heap sort
+ */
+int introSortDepth(size_t count) {
+	return 2 * (int)std::bit_width(count);
 }
 
 /**
- * Perform a quick sort on bid title
+ * Perform a quick sort on bid title, as an introsort
  * Average performance: O(n log(n))
- * Worst case performance O(n^2))
+ * Worst case performance O(n log(n))
  *
  * @param bids address of the vector<Bid> instance to be sorted
  * @param begin the beginning index to sort on
  * @param end the ending index to sort on
  */
 void quickSort(vector<Bid>& bids, int begin, int end) {
-	
+
 	//Check if the list contains less than 2 elements.
 	if (begin >= end) return;
 
-	//Use partition function to get the end point of the last element in the lower partition.
-	int pivot = partition(bids, begin, end);
+	introSort(bids, begin, end, introSortDepth(end - begin + 1));
+}
+
+/**
+ * Perform a quick sort on bid title, on several threads
+ *
+ * Each partition step forks the upper part as a task on a work
+ * stealing pool and carries on splitting the lower part itself.
+ * Ranges of PARALLEL_SORT_CUTOFF bids or fewer are not worth a
+ * task and are finished with the sequential introSort, which also
+ * inherits the remaining depth limit.
+ *
+ * @param bids address of the vector<Bid> instance to be sorted
+ * @param threadCount number of threads to sort with, including the caller
+ */
+void parallelQuickSort(vector<Bid>& bids, unsigned int threadCount) {
+	if (bids.size() < 2)
+		return;
+
+	WorkStealingPool pool(threadCount);
+	function<void(int, int, int)> sortRange = [&](int begin, int end, int depthLimit) {
+		while (end - begin >= PARALLEL_SORT_CUTOFF) {
+			if (depthLimit-- == 0) {
+				heapSort(bids, begin, end);
+				return;
+			}
+			int lessEnd, greaterBegin;
+			partition(bids, begin, end, lessEnd, greaterBegin);
+			pool.Submit([&sortRange, greaterBegin, end, depthLimit]() { sortRange(greaterBegin, end, depthLimit); });
+			end = lessEnd - 1;
+		}
+		introSort(bids, begin, end, depthLimit);
+	};
 
-	//Recursively call quick sort on both high and low partitions.
-	quickSort(bids, begin, pivot);
-	quickSort(bids, pivot + 1, end);
+	sortRange(0, (int)bids.size() - 1, introSortDepth(bids.size()));
+	pool.Wait();
 }
 
 // FIXME (1a): Implement the selection sort logic over bid.title
@@ -234,23 +932,657 @@ void selectionSort(vector<Bid>& bids) {
 	}
 }
 
+/**
+ * The first 8 bytes of a title as one integer, packed big endian
+ * and zero padded, so comparing two prefixes as integers gives the
+ * same order as comparing the strings, as far as 8 bytes go
+ *
+ * @param key The string to pack
+ * @return The packed prefix
+ */
+static inline uint64_t keyPrefix(std::string_view key) {
+	uint64_t prefix = 0;
+	for (size_t i = 0; i < 8; i++) {
+		prefix = (prefix << 8) | (i < key.size() ? (uint8_t)key[i] : 0);
+	}
+	return prefix;
+}
 
+//A bid's place in a key sort: its sort key (a title prefix, or an amount), and where the bid is in the vector. 16 bytes with padding.
+struct SortKey {
+	uint64_t prefix;
+	uint32_t index;
+};
 
+/**
+ * Work out the title order of the bids without moving any of them
+ *
+ * Sorts an array of {title prefix, index} keys instead of the bids
+ * themselves. A key is 16 bytes once padded, so four share a
+ * cache line, where a Bid struct alone is 104 bytes on 64 bit
+ * libstdc++. Most comparisons are settled by the prefixes, which
+ * sit side by side in one array; only when two prefixes tie are
+ * the full titles looked up and compared.
+ *
+ * @param bids the bids, left unchanged
+ * @return indices into bids, in title order
+ */
+vector<uint32_t> sortedOrder(const vector<Bid>& bids) {
+	vector<SortKey> keys(bids.size());
+	for (size_t i = 0; i < bids.size(); i++) {
+		keys[i].prefix = keyPrefix(bids[i].title);
+		keys[i].index = (uint32_t)i;
+	}
 
+	sort(keys.begin(), keys.end(), [&bids](const SortKey& a, const SortKey& b) {
+		if (a.prefix != b.prefix)
+			return a.prefix < b.prefix;
+		return bids[a.index].title < bids[b.index].title;
+	});
 
+	vector<uint32_t> order(keys.size());
+	for (size_t i = 0; i < keys.size(); i++) {
+		order[i] = keys[i].index;
+	}
+	return order;
+}
 
+/**
+ * Rearrange the bids into the given order in place, following each
+ * cycle of the permutation so every bid is moved exactly once
+ *
+ * @param bids the bids to rearrange
+ * @param order for each position, the index of the bid that belongs there; used up as the cycles are followed
+ */
+void applyOrder(vector<Bid>& bids, vector<uint32_t>& order) {
+	for (uint32_t start = 0; start < order.size(); start++) {
+		if (order[start] == start)
+			continue;
+
+		//Lift the first bid out, pull each bid of the cycle into the gap left by the one before, and drop the first bid into the last gap.
+		Bid first = std::move(bids[start]);
+		uint32_t gap = start;
+		while (order[gap] != start) {
+			uint32_t next = order[gap];
+			bids[gap] = std::move(bids[next]);
+			order[gap] = gap;
+			gap = next;
+		}
+		bids[gap] = std::move(first);
+		order[gap] = gap;
+	}
+}
 
+/**
+ * Sort the bids on title through a key/index array, then move each
+ * bid once into its final place
+ *
+ * @param bids address of the vector<Bid> instance to be sorted
+ */
+void keySort(vector<Bid>& bids) {
+	vector<uint32_t> order = sortedOrder(bids);
+	applyOrder(bids, order);
+}
 
+//A title as the multikey sort sees it: where its bytes are, and which bid it belongs to.
+struct TitleKey {
+	const char* text;
+	uint32_t length;
+	uint32_t index;
+};
 
+/**
+ * Byte of a title at a depth, or -1 past its end, so a shorter title sorts before any longer one it is a prefix of
+ */
+static inline int charAt(const TitleKey& key, size_t depth) {
+	return depth < key.length ? (unsigned char)key.text[depth] : -1;
+}
 
+/**
+ * Multikey quick sort (Bentley and Sedgewick) of titles that all
+ * share their first depth bytes
+ *
+ * Each step partitions on a single byte, three ways. The titles
+ * below and above the pivot byte are sorted at the same depth, and
+ * those equal to it move on to the next byte, so no byte of a
+ * shared prefix is ever compared twice, and the work is close to
+ * the length of the prefixes that tell the titles apart.
+ *
+ * @param keys The titles to sort
+ * @param count Number of titles
+ * @param depth Number of leading bytes they are known to share
+ */
+void multikeySort(TitleKey* keys, int count, size_t depth) {
+	while (count > INSERTION_SORT_CUTOFF) {
+		int first = charAt(keys[0], depth);
+		int middle = charAt(keys[count / 2], depth);
+		int last = charAt(keys[count - 1], depth);
+		int pivot = max(min(first, middle), min(max(first, middle), last));
+
+		//[0, low) is below the pivot byte, [low, i) equal to it, (high, count) above it.
+		int low = 0;
+		int i = 0;
+		int high = count - 1;
+		while (i <= high) {
+			int c = charAt(keys[i], depth);
+			if (c < pivot)
+				swap(keys[low++], keys[i++]);
+			else if (c > pivot)
+				swap(keys[i], keys[high--]);
+			else
+				i++;
+		}
 
+		multikeySort(keys, low, depth);
+		multikeySort(keys + high + 1, count - high - 1, depth);
 
+		//Titles that all ended here are equal, and already in place. The rest share one more byte.
+		if (pivot < 0)
+			return;
+		keys += low;
+		count = high + 1 - low;
+		depth++;
+	}
 
+	//Insertion sort what is left, comparing only the bytes after the shared prefix.
+	for (int i = 1; i < count; i++) {
+		TitleKey moving = keys[i];
+		std::string_view rest(moving.text + depth, moving.length - depth);
+		int j = i;
+		while (j > 0 && rest < std::string_view(keys[j - 1].text + depth, keys[j - 1].length - depth)) {
+			keys[j] = keys[j - 1];
+			j--;
+		}
+		keys[j] = moving;
+	}
+}
 
+/**
+ * Sort the bids on title with a multikey quick sort of their
+ * titles, then move each bid once into its final place
+ *
+ * @param bids address of the vector<Bid> instance to be sorted
+ */
+void multikeyQuickSort(vector<Bid>& bids) {
+	vector<TitleKey> keys(bids.size());
+	for (size_t i = 0; i < bids.size(); i++) {
+		keys[i].text = bids[i].title.data();
+		keys[i].length = (uint32_t)bids[i].title.size();
+		keys[i].index = (uint32_t)i;
+	}
+	multikeySort(keys.data(), (int)keys.size(), 0);
+
+	vector<uint32_t> order(keys.size());
+	for (size_t i = 0; i < keys.size(); i++) {
+		order[i] = keys[i].index;
+	}
+	applyOrder(bids, order);
+}
+
+/**
+ * An amount as an unsigned integer in the same order: the sign bit
+ * is flipped for positive amounts, and every bit for negative ones
+ */
+static inline uint64_t amountKey(double amount) {
+	uint64_t bits = std::bit_cast<uint64_t>(amount);
+	return (bits >> 63) ? ~bits : bits | (1ull << 63);
+}
+
+/**
+ * Sort the bids on amount with a least significant digit radix
+ * sort, one byte of the amount's 64 bit key per pass. Each pass is
+ * a counting sort, so it is stable and the passes compose. A pass
+ * where every key has the same byte, common in the high bytes of
+ * similar amounts, is skipped. Bids with the same amount keep
+ * their order.
+ *
+ * @param bids address of the vector<Bid> instance to be sorted
+ */
+void radixSortByAmount(vector<Bid>& bids) {
+	vector<SortKey> keys(bids.size());
+	vector<SortKey> scratch(bids.size());
+	for (size_t i = 0; i < bids.size(); i++) {
+		keys[i].prefix = amountKey(bids[i].amount);
+		keys[i].index = (uint32_t)i;
+	}
 
+	for (int shift = 0; shift < 64; shift += 8) {
+		size_t counts[256] = {};
+		for (const SortKey& key : keys) {
+			counts[(key.prefix >> shift) & 0xFF]++;
+		}
+		if (!keys.empty() && counts[(keys[0].prefix >> shift) & 0xFF] == keys.size())
+			continue;
+
+		//Turn the counts into the first position of each byte value, then scatter in order.
+		size_t position = 0;
+		for (size_t& count : counts) {
+			size_t bucket = count;
+			count = position;
+			position += bucket;
+		}
+		for (const SortKey& key : keys) {
+			scratch[counts[(key.prefix >> shift) & 0xFF]++] = key;
+		}
+		keys.swap(scratch);
+	}
 
+	vector<uint32_t> order(keys.size());
+	for (size_t i = 0; i < keys.size(); i++) {
+		order[i] = keys[i].index;
+	}
+	applyOrder(bids, order);
+}
 
+/**
+ * Make a bid from the fields of a row of the CSV file, taking the
+ * strings out of them rather than copying. The row must have at
+ * least 9 fields.
+ */
+Bid bidFromRow(vector<string>& fields) {
+	Bid bid;
+	bid.bidId = std::move(fields[1]);
+	bid.title = std::move(fields[0]);
+	bid.fund = std::move(fields[8]);
+	bid.amount = strToDouble(fields[4], '$');
+	return bid;
+}
 
+/**
+ * Roughly the memory a bid and its input row take: the structs plus their strings' characters
+ */
+static inline size_t bidFootprint(const Bid& bid, const string& row) {
+	return sizeof(Bid) + bid.bidId.capacity() + bid.title.capacity() + bid.fund.capacity() + sizeof(string) + row.capacity();
+}
+
+/**
+ * Join a row's fields back into a line of CSV, without the line
+ * break. A field goes in quotes if it holds a comma, a quote or a
+ * line break, with any quotes in it doubled.
+ */
+string csvLine(const vector<string>& fields) {
+	string line;
+	for (size_t i = 0; i < fields.size(); i++) {
+		if (i > 0)
+			line += ',';
+		const string& field = fields[i];
+		if (field.find_first_of(",\"\r\n") == string::npos) {
+			line += field;
+			continue;
+		}
+		line += '"';
+		for (char c : field) {
+			if (c == '"')
+				line += '"';
+			line += c;
+		}
+		line += '"';
+	}
+	return line;
+}
+
+/**
+ * Sort a CSV file of bids on title into a new CSV file, for files
+ * too large to load in memory.
+ *
+ * The input is read a row at a time. Bids are gathered with their
+ * whole rows until they fill the memory budget, put in title order
+ * with a key sort, and written to a run file, so there are about
+ * input size / budget runs. The runs are then merged in a single
+ * pass through a loser tree, the budget split between one read
+ * buffer per run and the output. Every byte is read and written
+ * sequentially, twice. The output has the input's header and
+ * columns, so it loads like the input does.
+ *
+ * @param csvPath the CSV file of bids to sort
+ * @param outputPath where to write the sorted CSV file
+ * @param memoryBudget bytes to hold bids and buffers in
+ * @return the number of runs the input was split into
+ */
+size_t externalSort(const string& csvPath, const string& outputPath, size_t memoryBudget) {
+	CsvStreamReader reader(csvPath);
+	if (!reader.IsOpen()) {
+		cerr << "Unable to open " << csvPath << endl;
+		return 0;
+	}
+
+	//Leave a quarter of the budget for the vector's own growth while gathering a run.
+	size_t runBudget = memoryBudget / 4 * 3;
+	vector<string> runPaths;
+	vector<string> fields;
+	vector<Bid> run;
+	vector<string> runRows;
+	size_t runBytes = 0;
+	size_t skipped = 0;
+
+	//The bids are sorted through an index, so each stays paired with its row.
+	auto spillRun = [&]() {
+		vector<uint32_t> order = sortedOrder(run);
+		runPaths.push_back(outputPath + ".run" + to_string(runPaths.size()));
+		RunWriter writer(runPaths.back(), EXTERNAL_SORT_IO_BUFFER);
+		for (uint32_t index : order) {
+			writer.Write(run[index], runRows[index]);
+		}
+		run.clear();
+		runRows.clear();
+		runBytes = 0;
+	};
+
+	//The first row is the header, written back out as it is.
+	reader.NextRow(fields);
+	string header = csvLine(fields);
+	while (reader.NextRow(fields)) {
+		if (fields.size() < 9) {
+			skipped++;
+			continue;
+		}
+		string row = csvLine(fields);
+		Bid bid = bidFromRow(fields);
+		runBytes += bidFootprint(bid, row);
+		run.push_back(std::move(bid));
+		runRows.push_back(std::move(row));
+		if (runBytes >= runBudget)
+			spillRun();
+	}
+	if (!run.empty() || runPaths.empty())
+		spillRun();
+	vector<Bid>().swap(run);
+	vector<string>().swap(runRows);
+
+	if (skipped > 0)
+		cerr << skipped << " rows with too few fields skipped" << endl;
+
+	//Split the budget between a read buffer per run and the output's buffer.
+	size_t bufferSize = max(memoryBudget / (runPaths.size() + 1), EXTERNAL_SORT_MIN_BUFFER);
+	vector< unique_ptr< RunReader > > readers;
+	vector< RunReader* > runs;
+	for (const string& path : runPaths) {
+		readers.push_back(make_unique<RunReader>(path, bufferSize));
+		runs.push_back(readers.back().get());
+	}
+
+	FILE* output = fopen(outputPath.c_str(), "wb");
+	if (output == nullptr) {
+		cerr << "Unable to create " << outputPath << endl;
+	}
+	else {
+		vector<char> outputBuffer(bufferSize);
+		setvbuf(output, outputBuffer.data(), _IOFBF, outputBuffer.size());
+		fwrite(header.data(), 1, header.size(), output);
+		fputc('\n', output);
+
+		LoserTree tree(runs);
+		for (int winner = tree.Winner(); winner >= 0; winner = tree.Winner()) {
+			const string& row = runs[winner]->CurrentRow();
+			fwrite(row.data(), 1, row.size(), output);
+			fputc('\n', output);
+			tree.Advance();
+		}
+		fclose(output);
+	}
+
+	readers.clear();
+	for (const string& path : runPaths) {
+		remove(path.c_str());
+	}
+	return runPaths.size();
+}
+
+/**
+ * Rearrange a range on title so the bid at nth is the one a full
+ * sort would put there, with none after it lower and none before
+ * it higher. This is quick select over the same three-way
+ * partition as introSort, following only the part that holds nth,
+ * so it is O(n) on average. Once depthLimit partitions deep, what
+ * is left of the range is heap sorted, so the worst case is
+ * O(n log(n)).
+ *
+ * @param bids address of the vector<Bid> instance to rearrange
+ * @param begin the beginning index of the range
+ * @param end the ending index of the range
+ * @param nth the index to put the right bid at
+ * @param depthLimit partitions left before falling back to heap sort
+ */
+void introSelect(vector<Bid>& bids, int begin, int end, int nth, int depthLimit) {
+	while (end - begin + 1 > INSERTION_SORT_CUTOFF) {
+		if (depthLimit-- == 0) {
+			heapSort(bids, begin, end);
+			return;
+		}
+
+		int lessEnd, greaterBegin;
+		partition(bids, begin, end, lessEnd, greaterBegin);
+		if (nth < lessEnd)
+			end = lessEnd - 1;
+		else if (nth >= greaterBegin)
+			begin = greaterBegin;
+		else
+			return;
+	}
+	insertionSort(bids, begin, end);
+}
+
+/**
+ * Put the k bids with the lowest titles at the front of the vector,
+ * in order, leaving the rest after them in no particular order.
+ * introSelect does the O(n) part, so only the k front bids are
+ * sorted: O(n + k log(k)).
+ *
+ * @param bids address of the vector<Bid> instance to rearrange
+ * @param k how many bids to sort to the front
+ */
+void partialSortByTitle(vector<Bid>& bids, size_t k) {
+	k = min(k, bids.size());
+	if (k == 0)
+		return;
+	if (k < bids.size())
+		introSelect(bids, 0, (int)bids.size() - 1, (int)k - 1, introSortDepth(bids.size()));
+	quickSort(bids, 0, (int)k - 1);
+}
+
+/**
+ * Whether bid a ranks above bid b in a top bids query: the higher
+ * amount, or on the same amount the lower id, so the answer does
+ * not depend on the order the bids were seen in
+ */
+static inline bool ranksAbove(const Bid& a, const Bid& b) {
+	if (a.amount != b.amount)
+		return a.amount > b.amount;
+	return a.bidId < b.bidId;
+}
+
+//A top bids heap holds either the bids themselves or pointers into a vector of them.
+static inline const Bid& bidOf(const Bid& bid) { return bid; }
+static inline const Bid& bidOf(const Bid* bid) { return *bid; }
+
+/**
+ * Offer a bid to a heap of the k top ranked bids seen so far. The
+ * top of the heap is the lowest ranked of them, the one a better
+ * bid pushes out, so a bid that does not make the cut costs a
+ * single comparison and one that does O(log(k)).
+ *
+ * @param heap the heap, at most k bids
+ * @param k how many bids the heap keeps
+ * @param entry the bid, or a pointer to it
+ */
+template <typename Entry>
+void offerTopBid(vector<Entry>& heap, size_t k, Entry entry) {
+	auto ranksLower = [](const Entry& a, const Entry& b) { return ranksAbove(bidOf(a), bidOf(b)); };
+	if (heap.size() < k) {
+		heap.push_back(std::move(entry));
+		push_heap(heap.begin(), heap.end(), ranksLower);
+	}
+	else if (k > 0 && ranksAbove(bidOf(entry), bidOf(heap.front()))) {
+		pop_heap(heap.begin(), heap.end(), ranksLower);
+		heap.back() = std::move(entry);
+		push_heap(heap.begin(), heap.end(), ranksLower);
+	}
+}
+
+/**
+ * Find the k highest bids by amount, highest first, without sorting
+ * the rest. Each thread keeps a bounded heap over its own slice of
+ * the vector, holding pointers so no bid is copied until the end,
+ * and the heaps are then merged into one. O(n log(k)) work in all.
+ *
+ * @param bids the bids to search, left unchanged
+ * @param k how many bids to return
+ * @param threadCount threads to search with, including the caller
+ * @return up to k bids, highest amount first
+ */
+vector<Bid> topBidsByAmount(const vector<Bid>& bids, size_t k, unsigned int threadCount) {
+
+	//A slice shorter than PARALLEL_SORT_CUTOFF is not worth a task of its own.
+	size_t sliceCount = max<size_t>(min<size_t>(threadCount, bids.size() / PARALLEL_SORT_CUTOFF), 1);
+	vector< vector< const Bid* > > heaps(sliceCount);
+	auto searchSlice = [&](size_t slice) {
+		size_t begin = bids.size() * slice / sliceCount;
+		size_t end = bids.size() * (slice + 1) / sliceCount;
+		for (size_t i = begin; i < end; i++) {
+			offerTopBid(heaps[slice], k, &bids[i]);
+		}
+	};
+
+	if (sliceCount == 1)
+		searchSlice(0);
+	else {
+		WorkStealingPool pool(threadCount);
+		for (size_t slice = 0; slice < sliceCount; slice++) {
+			pool.Submit([&searchSlice, slice]() { searchSlice(slice); });
+		}
+		pool.Wait();
+	}
+
+	vector<const Bid*> top = std::move(heaps[0]);
+	for (size_t slice = 1; slice < sliceCount; slice++) {
+		for (const Bid* bid : heaps[slice]) {
+			offerTopBid(top, k, bid);
+		}
+	}
+	sort(top.begin(), top.end(), [](const Bid* a, const Bid* b) { return ranksAbove(*a, *b); });
+
+	vector<Bid> result;
+	result.reserve(top.size());
+	for (const Bid* bid : top) {
+		result.push_back(*bid);
+	}
+	return result;
+}
+
+/**
+ * Find the k highest bids by amount in a CSV file, highest first,
+ * reading it a row at a time. Only the heap of k bids is ever held,
+ * never the whole file.
+ *
+ * @param csvPath the CSV file of bids to search
+ * @param k how many bids to return
+ * @return up to k bids, highest amount first
+ */
+vector<Bid> streamTopBidsByAmount(const string& csvPath, size_t k) {
+	CsvStreamReader reader(csvPath);
+	if (!reader.IsOpen()) {
+		cerr << "Unable to open " << csvPath << endl;
+		return {};
+	}
+
+	vector<Bid> top;
+	vector<string> fields;
+
+	//The first row is the header.
+	reader.NextRow(fields);
+	while (reader.NextRow(fields)) {
+		if (fields.size() >= 9)
+			offerTopBid(top, k, bidFromRow(fields));
+	}
+	sort(top.begin(), top.end(), ranksAbove);
+	return top;
+}
+
+/**
+ * Load the bids with loadBids on 1, 2, 4, ... threads, up to the
+ * count asked for, and report rows and bytes read per second
+ *
+ * @param csvPath the path to the CSV file to load
+ * @param maxThreads the most threads to try
+ */
+void benchmarkLoad(string csvPath, unsigned int maxThreads) {
+    size_t fileBytes = MappedCsv(csvPath).Size();
+    for (unsigned int threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        auto start = chrono::steady_clock::now();
+        vector<Bid> bids = loadBids(csvPath, threadCount);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << "threads: " << threadCount << " | rows/sec: " << (unsigned long long)(bids.size() / seconds)
+             << " | GB/s: " << fileBytes / seconds / 1e9 << endl;
+    }
+}
+
+/**
+ * Sort copies of the bids with parallelQuickSort on 1, 2, 4, ...
+ * threads, up to the count asked for, and report the wall clock
+ * time and the speedup over one thread for each
+ *
+ * @param bids the bids to sort, left unchanged
+ * @param maxThreads the most threads to try
+ */
+void benchmarkParallelSort(const vector<Bid>& bids, unsigned int maxThreads) {
+    double oneThreadSeconds = 0;
+    for (unsigned int threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        vector<Bid> copy = bids;
+
+        auto start = chrono::steady_clock::now();
+        parallelQuickSort(copy, threadCount);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (threadCount == 1) {
+            oneThreadSeconds = seconds;
+        }
+
+        bool sorted = is_sorted(copy.begin(), copy.end(), [](const Bid& a, const Bid& b) { return a.title < b.title; });
+        cout << "threads: " << threadCount << " | " << seconds << " seconds | speedup: " << oneThreadSeconds / seconds
+             << (sorted ? "" : " | NOT SORTED") << endl;
+    }
+}
+
+/**
+ * Time each of the sorts on its own copy of the bids, and check
+ * the result is sorted. Selection sort is quadratic, so it is only
+ * run on up to SELECTION_SORT_BENCHMARK_LIMIT bids.
+ *
+ * @param bids the bids to sort, left unchanged
+ */
+void benchmarkSorts(const vector<Bid>& bids) {
+    auto byTitle = [](const Bid& a, const Bid& b) { return a.title < b.title; };
+    auto byAmount = [](const Bid& a, const Bid& b) { return a.amount < b.amount; };
+
+    struct SortEntry {
+        const char* name;
+        function<void(vector<Bid>&)> sort;
+        function<bool(const Bid&, const Bid&)> less;
+        size_t maxBids;
+    };
+    const SortEntry sorts[] = {
+        { "selection sort", [](vector<Bid>& copy) { selectionSort(copy); }, byTitle, SELECTION_SORT_BENCHMARK_LIMIT },
+        { "quick sort (introsort)", [](vector<Bid>& copy) { quickSort(copy, 0, (int)copy.size() - 1); }, byTitle, SIZE_MAX },
+        { "key sort", [](vector<Bid>& copy) { keySort(copy); }, byTitle, SIZE_MAX },
+        { "multikey quick sort", [](vector<Bid>& copy) { multikeyQuickSort(copy); }, byTitle, SIZE_MAX },
+        { "radix sort by amount", [](vector<Bid>& copy) { radixSortByAmount(copy); }, byAmount, SIZE_MAX },
+    };
+
+    for (const SortEntry& entry : sorts) {
+        if (bids.size() > entry.maxBids) {
+            cout << entry.name << ": skipped, more than " << entry.maxBids << " bids" << endl;
+            continue;
+        }
+        vector<Bid> copy = bids;
+
+        auto start = chrono::steady_clock::now();
+        entry.sort(copy);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        bool sorted = is_sorted(copy.begin(), copy.end(), entry.less);
+        cout << entry.name << ": " << seconds << " seconds" << (sorted ? "" : " | NOT SORTED") << endl;
+    }
+}
 
 /**
  * Simple C function to convert a string to a double
@@ -270,6 +1602,27 @@ double strToDouble(string str, char ch) {
  */
 int main(int argc, char* argv[]) {
 
+    // take out --threads N (or --threads=N), the threads for loading and the parallel sorts, and --memory MB (or --memory=MB),
+    // the external sort's memory budget, leaving the other arguments in place
+    unsigned int threadCount = max(thread::hardware_concurrency(), 1u);
+    size_t memoryMB = EXTERNAL_SORT_DEFAULT_MEMORY_MB;
+    vector<char*> args;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCount = max(atoi(argv[++i]), 1);
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            threadCount = max(atoi(argv[i] + 10), 1);
+        } else if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc) {
+            memoryMB = max(atoi(argv[++i]), 1);
+        } else if (strncmp(argv[i], "--memory=", 9) == 0) {
+            memoryMB = max(atoi(argv[i] + 9), 1);
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    argc = (int)args.size();
+    argv = args.data();
+
     // process command line arguments
     string csvPath;
     switch (argc) {
@@ -293,7 +1646,18 @@ int main(int argc, char* argv[]) {
         cout << "  2. Display All Bids" << endl;
         cout << "  3. Selection Sort All Bids" << endl;
         cout << "  4. Quick Sort All Bids" << endl;
+        cout << "  5. Parallel Quick Sort All Bids (" << threadCount << " threads)" << endl;
+        cout << "  6. Parallel Sort Benchmark" << endl;
+        cout << "  7. Key Sort All Bids" << endl;
+        cout << "  8. Sort Benchmark" << endl;
         cout << "  9. Exit" << endl;
+        cout << "  10. Multikey Quick Sort All Bids" << endl;
+        cout << "  11. Radix Sort All Bids by Amount" << endl;
+        cout << "  12. External Sort Bids to File (" << memoryMB << " MB)" << endl;
+        cout << "  13. Top K Bids by Amount" << endl;
+        cout << "  14. First K Bids by Title" << endl;
+        cout << "  15. Top K Bids by Amount from File" << endl;
+        cout << "  16. Load Benchmark" << endl;
         cout << "Enter choice: ";
         cin >> choice;
 
@@ -304,7 +1668,7 @@ int main(int argc, char* argv[]) {
             ticks = clock();
 
             // Complete the method call to load the bids
-            bids = loadBids(csvPath);
+            bids = loadBids(csvPath, threadCount);
 
             cout << bids.size() << " bids read" << endl;
 
@@ -347,6 +1711,113 @@ int main(int argc, char* argv[]) {
 				displayBid(bids.at(i));
 			}
 
+			break;
+
+		case 5: {
+			// clock() adds up the time of every thread, so the wall clock time is shown as well
+			ticks = clock();
+			auto start = chrono::steady_clock::now();
+			parallelQuickSort(bids, threadCount);
+			double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			ticks = clock() - ticks;
+			cout << "time: " << ticks << " ticks." << endl;
+			cout << "time: " << seconds << " seconds." << endl;
+
+			break;
+		}
+
+		case 6:
+			benchmarkParallelSort(bids, threadCount);
+
+			break;
+
+		case 7:
+			ticks = clock();
+			keySort(bids);
+			ticks = clock() - ticks;
+			cout << "time: " << ticks << " ticks." << endl;
+			cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds." << endl;
+
+			break;
+
+		case 8:
+			benchmarkSorts(bids);
+
+			break;
+
+		case 10:
+			ticks = clock();
+			multikeyQuickSort(bids);
+			ticks = clock() - ticks;
+			cout << "time: " << ticks << " ticks." << endl;
+			cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds." << endl;
+
+			break;
+
+		case 11:
+			ticks = clock();
+			radixSortByAmount(bids);
+			ticks = clock() - ticks;
+			cout << "time: " << ticks << " ticks." << endl;
+			cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds." << endl;
+
+			break;
+
+		case 12: {
+			// sorts the file on disk, without loading it into the bids vector
+			string outputPath = csvPath + ".sorted.csv";
+			auto start = chrono::steady_clock::now();
+			size_t runCount = externalSort(csvPath, outputPath, memoryMB << 20);
+			double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			FILE* input = fopen(csvPath.c_str(), "rb");
+			long inputBytes = 0;
+			if (input != nullptr) {
+				fseek(input, 0, SEEK_END);
+				inputBytes = ftell(input);
+				fclose(input);
+			}
+			cout << "sorted into " << outputPath << " from " << runCount << " runs" << endl;
+			cout << "time: " << seconds << " seconds, " << inputBytes / seconds / (1 << 20) << " MB/s" << endl;
+
+			break;
+		}
+
+		case 13:
+		case 14:
+		case 15: {
+			size_t k;
+			cout << "Enter k: ";
+			cin >> k;
+
+			// top k works on a copy, first k rearranges the bids in place, and the file search never loads them
+			vector<Bid> result;
+			auto start = chrono::steady_clock::now();
+			if (choice == 13) {
+				result = topBidsByAmount(bids, k, threadCount);
+			} else if (choice == 14) {
+				partialSortByTitle(bids, k);
+			} else {
+				result = streamTopBidsByAmount(csvPath, k);
+			}
+			double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+			if (choice == 14) {
+				for (size_t i = 0; i < min(k, bids.size()); i++) {
+					displayBid(bids[i]);
+				}
+			} else {
+				for (const Bid& bid : result) {
+					displayBid(bid);
+				}
+			}
+			cout << "time: " << seconds << " seconds." << endl;
+
+			break;
+		}
+
+		case 16:
+			benchmarkLoad(csvPath, threadCount);
+
 			break;
 		}
     }